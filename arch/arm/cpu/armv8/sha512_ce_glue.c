@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * sha512_ce_glue.c - SHA-384/SHA-512 secure hash using ARMv8.2 Crypto
+ * Extensions
+ */
+
+#include <common.h>
+#include <asm/system.h>
+#include <u-boot/sha512.h>
+
+extern void sha512_armv8_ce_process(uint64_t state[8], uint8_t const *src,
+				    uint32_t blocks);
+
+/*
+ * Whether the SHA-512 instructions are there, -1 until checked. Reading the ID
+ * register may trap to a hypervisor, so only do that once.
+ */
+static int sha512_hw = -1;
+
+void sha512_process(sha512_context *ctx, const unsigned char *data,
+		    unsigned int blocks)
+{
+	if (!blocks)
+		return;
+
+	if (sha512_hw < 0)
+		sha512_hw = cpu_has_sha512() ? 1 : 0;
+	if (sha512_hw)
+		sha512_armv8_ce_process(ctx->state, data, blocks);
+	else
+		sha512_process_generic(ctx, data, blocks);
+}
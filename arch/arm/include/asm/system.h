@@ -201,6 +201,35 @@ static inline unsigned long read_mpidr(void)
 	return val;
 }
 
+/**
+ * cpu_has_crc32() - Check for the optional ARMv8.0 CRC32 instructions
+ *
+ * Return: non-zero if the CRC32 and CRC32C instructions are implemented
+ */
+static inline int cpu_has_crc32(void)
+{
+	unsigned long isar0;
+
+	asm volatile("mrs %0, id_aa64isar0_el1" : "=r" (isar0));
+
+	return (isar0 >> 16) & 0xf;
+}
+
+/**
+ * cpu_has_sha512() - Check for the optional ARMv8.2 SHA-512 instructions
+ *
+ * Return: non-zero if the SHA512H, SHA512H2, SHA512SU0 and SHA512SU1
+ * instructions are implemented
+ */
+static inline int cpu_has_sha512(void)
+{
+	unsigned long isar0;
+
+	asm volatile("mrs %0, id_aa64isar0_el1" : "=r" (isar0));
+
+	return ((isar0 >> 12) & 0xf) >= 2;
+}
+
 #define BSP_COREID	0
 
 void __asm_flush_dcache_all(void);
@@ -161,6 +161,16 @@ static inline unsigned int cpuid_edx(unsigned int op)
 	return edx;
 }
 
+/**
+ * cpu_has_sse4_2() - Check for SSE4.2, which includes the crc32 instruction
+ *
+ * Return: non-zero if SSE4.2 is supported
+ */
+static inline int cpu_has_sse4_2(void)
+{
+	return cpuid_ecx(1) & (1 << 20);
+}
+
 #if !CONFIG_IS_ENABLED(X86_64)
 
 /* Standard macro to see if a specific flag is changeable */
@@ -63,6 +63,39 @@ struct image_region *fit_region_make_list(const void *fit,
 	return region;
 }
 
+/**
+ * fit_image_calc_checksum() - Calculate a checksum, reusing image digests
+ *
+ * This is used in place of the checksum algorithm's calculate() method when
+ * checking an image signature, so that the image data is not hashed again if
+ * a hash node or another signature has already done so.
+ *
+ * @name: Name of the checksum algorithm, e.g. "sha256"
+ * @region: Regions to hash
+ * @region_count: Number of regions
+ * @checksum: Returns the checksum
+ * Return: 0 if OK, -ve on error
+ */
+static int fit_image_calc_checksum(const char *name,
+				   const struct image_region *region,
+				   int region_count, uint8_t *checksum)
+{
+	struct hash_algo *algo;
+	int len, ret;
+
+	if (region_count == 1 &&
+	    fit_digest_lookup(name, region->data, region->size, checksum, &len))
+		return 0;
+	ret = hash_calculate(name, region, region_count, checksum);
+	if (ret)
+		return ret;
+	if (region_count == 1 && !hash_progressive_lookup_algo(name, &algo))
+		fit_digest_save(name, region->data, region->size, checksum,
+				algo->digest_size);
+
+	return 0;
+}
+
 static int fit_image_setup_verify(struct image_sign_info *info,
 				  const void *fit, int noffset,
 				  const void *key_blob, int required_keynode,
@@ -108,6 +141,7 @@ int fit_image_check_sig(const void *fit, int noffset, const void *data,
 			size_t size, const void *key_blob, int required_keynode,
 			char **err_msgp)
 {
+	struct checksum_algo checksum;
 	struct image_sign_info info;
 	struct image_region region;
 	uint8_t *fit_value;
@@ -118,6 +152,10 @@ int fit_image_check_sig(const void *fit, int noffset, const void *data,
 				   required_keynode, err_msgp))
 		return -1;
 
+	memcpy(&checksum, info.checksum, sizeof(checksum));
+	checksum.calculate = fit_image_calc_checksum;
+	info.checksum = &checksum;
+
 	if (fit_image_hash_get_value(fit, noffset, &fit_value,
 				     &fit_value_len)) {
 		*err_msgp = "Can't get hash value property";
@@ -1232,6 +1232,90 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp)
 	return 0;
 }
 
+/* Number of different hash algorithms whose digests are kept for reuse */
+#define FIT_DIGEST_COUNT	3
+
+/**
+ * struct fit_digests - Digests of the image data being verified
+ *
+ * An image often has a hash node and a signature node which use the same hash
+ * algorithm, and each required key checks the signatures again. Keep the
+ * digests calculated while verifying an image, so that its data, which may be
+ * very large, is only hashed once with each algorithm.
+ *
+ * @data: Image data
+ * @size: Size of image data in bytes
+ * @count: Number of digests in use
+ * @digest: Digests calculated so far
+ * @digest.algo: Name of the hash algorithm, e.g. "sha256"
+ * @digest.len: Length of the digest in bytes
+ * @digest.value: Digest value
+ */
+struct fit_digests {
+	const void *data;
+	size_t size;
+	int count;
+	struct {
+		const char *algo;
+		int len;
+		uint8_t value[FIT_MAX_HASH_LEN];
+	} digest[FIT_DIGEST_COUNT];
+};
+
+/* Digests for the image being verified, or NULL if none */
+static struct fit_digests *fit_digests;
+
+/* Number of digests passed to fit_digest_save() and found, for tests */
+static int fit_digest_calcs;
+static int fit_digest_hits;
+
+bool fit_digest_lookup(const char *algo, const void *data, size_t size,
+		       uint8_t *value, int *value_lenp)
+{
+	struct fit_digests *digests = fit_digests;
+	int i;
+
+	if (!digests || data != digests->data || size != digests->size)
+		return false;
+	for (i = 0; i < digests->count; i++) {
+		if (!strcmp(algo, digests->digest[i].algo)) {
+			memcpy(value, digests->digest[i].value,
+			       digests->digest[i].len);
+			*value_lenp = digests->digest[i].len;
+			fit_digest_hits++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void fit_digest_save(const char *algo, const void *data, size_t size,
+		     const uint8_t *value, int value_len)
+{
+	struct fit_digests *digests = fit_digests;
+	int i;
+
+	fit_digest_calcs++;
+	if (!digests || data != digests->data || size != digests->size ||
+	    digests->count == FIT_DIGEST_COUNT || value_len > FIT_MAX_HASH_LEN)
+		return;
+	i = digests->count++;
+	digests->digest[i].algo = algo;
+	digests->digest[i].len = value_len;
+	memcpy(digests->digest[i].value, value, value_len);
+}
+
+int fit_digest_calc_count(void)
+{
+	return fit_digest_calcs;
+}
+
+int fit_digest_hit_count(void)
+{
+	return fit_digest_hits;
+}
+
 /**
  * calculate_hash - calculate and return hash for provided input data
  * @data: pointer to the input data
@@ -1326,9 +1410,12 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		return -1;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
-		*err_msgp = "Unsupported hash algorithm";
-		return -1;
+	if (!fit_digest_lookup(algo, data, size, value, &value_len)) {
+		if (calculate_hash(data, size, algo, value, &value_len)) {
+			*err_msgp = "Unsupported hash algorithm";
+			return -1;
+		}
+		fit_digest_save(algo, data, size, value, value_len);
 	}
 
 	if (value_len != fit_value_len) {
@@ -1346,11 +1433,17 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 			       const void *key_blob, const void *data,
 			       size_t size)
 {
+	struct fit_digests digests;
 	int		noffset = 0;
 	char		*err_msg = "";
 	int verify_all = 1;
 	int ret;
 
+	digests.data = data;
+	digests.size = size;
+	digests.count = 0;
+	fit_digests = &digests;
+
 	/* Verify all required signatures */
 	if (FIT_IMAGE_ENABLE_VERIFY &&
 	    fit_image_verify_required_sigs(fit, image_noffset, data, size,
@@ -1397,10 +1490,12 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 		err_msg = "Corrupted or truncated tree";
 		goto error;
 	}
+	fit_digests = NULL;
 
 	return 1;
 
 error:
+	fit_digests = NULL;
 	printf(" error!\n%s for '%s' hash node in '%s' image node\n",
 	       err_msg, fit_get_name(fit, noffset, NULL),
 	       fit_get_name(fit, image_noffset, NULL));
@@ -13,16 +13,34 @@
 static int blkc_show(struct cmd_tbl *cmdtp, int flag,
 		     int argc, char *const argv[])
 {
+	struct block_cache_dev_stats dstats;
 	struct block_cache_stats stats;
+	int i;
+
 	blkcache_stats(&stats);
 
 	printf("hits: %u\n"
 	       "misses: %u\n"
+	       "readaheads: %u\n"
 	       "entries: %u\n"
+	       "size: %lu\n"
 	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
-	       stats.max_blocks_per_entry, stats.max_entries);
+	       "max cache entries: %u\n"
+	       "max size: %lu\n"
+	       "readahead blocks: %u\n",
+	       stats.hits, stats.misses, stats.readaheads, stats.entries,
+	       stats.size, stats.max_blocks_per_entry, stats.max_entries,
+	       stats.max_size, stats.readahead_blocks);
+
+	for (i = 0; !blkcache_dev_stats(i, &dstats); i++) {
+		if (!i)
+			printf("\n%-10s %4s %10s %10s %10s\n", "interface",
+			       "dev", "hits", "misses", "readaheads");
+		printf("%-10s %4d %10u %10u %10u\n",
+		       blk_get_uclass_name(dstats.iftype), dstats.devnum,
+		       dstats.hits, dstats.misses, dstats.readaheads);
+	}
+
 	return 0;
 }
 
@@ -41,9 +59,31 @@ static int blkc_configure(struct cmd_tbl *cmdtp, int flag,
 	return 0;
 }
 
+static int blkc_size(struct cmd_tbl *cmdtp, int flag,
+		     int argc, char *const argv[])
+{
+	struct block_cache_stats stats;
+	unsigned long size;
+	unsigned readahead;
+
+	if (argc < 2 || argc > 3)
+		return CMD_RET_USAGE;
+
+	blkcache_stats(&stats);
+	size = simple_strtoul(argv[1], 0, 0);
+	readahead = stats.readahead_blocks;
+	if (argc == 3)
+		readahead = simple_strtoul(argv[2], 0, 0);
+	blkcache_configure_size(size, readahead);
+	printf("changed to max of %lu bytes, reading ahead up to %u blocks\n",
+	       size, readahead);
+	return 0;
+}
+
 static struct cmd_tbl cmd_blkc_sub[] = {
 	U_BOOT_CMD_MKENT(show, 0, 0, blkc_show, "", ""),
 	U_BOOT_CMD_MKENT(configure, 3, 0, blkc_configure, "", ""),
+	U_BOOT_CMD_MKENT(size, 3, 0, blkc_size, "", ""),
 };
 
 static __maybe_unused void blkc_reloc(void)
@@ -85,4 +125,6 @@ U_BOOT_CMD(
 	"show - show and reset statistics\n"
 	"blkcache configure <blocks> <entries> "
 	"- set max blocks per entry and max cache entries\n"
+	"blkcache size <bytes> [<readahead>] "
+	"- set max bytes cached and max blocks to read ahead\n"
 );
@@ -48,6 +48,16 @@ static int do_dm_dump_mem(struct cmd_tbl *cmdtp, int flag, int argc,
 }
 #endif /* DM_STATS */
 
+#if CONFIG_IS_ENABLED(DM_STATS) && CONFIG_IS_ENABLED(OFNODE_PROP_CACHE)
+static int do_dm_dump_props(struct cmd_tbl *cmdtp, int flag, int argc,
+			    char *const argv[])
+{
+	dm_dump_prop_stats();
+
+	return 0;
+}
+#endif
+
 static int do_dm_dump_static_driver_info(struct cmd_tbl *cmdtp, int flag,
 					 int argc, char * const argv[])
 {
@@ -56,6 +66,20 @@ static int do_dm_dump_static_driver_info(struct cmd_tbl *cmdtp, int flag,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(DM_TIMING)
+static int do_dm_dump_timing(struct cmd_tbl *cmdtp, int flag, int argc,
+			     char *const argv[])
+{
+	bool sort;
+
+	sort = argc > 1 && !strcmp(argv[1], "-s");
+
+	dm_dump_timing(sort);
+
+	return 0;
+}
+#endif
+
 static int do_dm_dump_tree(struct cmd_tbl *cmdtp, int flag, int argc,
 			   char *const argv[])
 {
@@ -84,13 +108,31 @@ static int do_dm_dump_uclass(struct cmd_tbl *cmdtp, int flag, int argc,
 #define DM_MEM
 #endif
 
+#if CONFIG_IS_ENABLED(DM_STATS) && CONFIG_IS_ENABLED(OFNODE_PROP_CACHE)
+#define DM_PROPS_HELP	"dm props         Show property lookups for each node\n"
+#define DM_PROPS	U_BOOT_SUBCMD_MKENT(props, 1, 1, do_dm_dump_props),
+#else
+#define DM_PROPS_HELP
+#define DM_PROPS
+#endif
+
+#if CONFIG_IS_ENABLED(DM_TIMING)
+#define DM_TIMING_HELP	"dm timing [-s]   Show time taken to probe devices (-s=sort)\n"
+#define DM_TIMING	U_BOOT_SUBCMD_MKENT(timing, 2, 1, do_dm_dump_timing),
+#else
+#define DM_TIMING_HELP
+#define DM_TIMING
+#endif
+
 #if IS_ENABLED(CONFIG_SYS_LONGHELP)
 static char dm_help_text[] =
 	"compat        Dump list of drivers with compatibility strings\n"
 	"dm devres        Dump list of device resources for each device\n"
 	"dm drivers       Dump list of drivers with uclass and instances\n"
 	DM_MEM_HELP
+	DM_PROPS_HELP
 	"dm static        Dump list of drivers with static platform data\n"
+	DM_TIMING_HELP
 	"dm tree [-s]     Dump tree of driver model devices (-s=sort)\n"
 	"dm uclass        Dump list of instances for each uclass"
 	;
@@ -101,6 +143,8 @@ U_BOOT_CMD_WITH_SUBCMDS(dm, "Driver model low level access", dm_help_text,
 	U_BOOT_SUBCMD_MKENT(devres, 1, 1, do_dm_dump_devres),
 	U_BOOT_SUBCMD_MKENT(drivers, 1, 1, do_dm_dump_drivers),
 	DM_MEM
+	DM_PROPS
 	U_BOOT_SUBCMD_MKENT(static, 1, 1, do_dm_dump_static_driver_info),
+	DM_TIMING
 	U_BOOT_SUBCMD_MKENT(tree, 2, 1, do_dm_dump_tree),
 	U_BOOT_SUBCMD_MKENT(uclass, 1, 1, do_dm_dump_uclass));
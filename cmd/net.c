@@ -647,8 +647,31 @@ static int do_net_list(struct cmd_tbl *cmdtp, int flag, int argc, char *const ar
 	return CMD_RET_SUCCESS;
 }
 
+static int do_net_stats(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
+{
+	const struct eth_stats *stats;
+	const struct udevice *dev;
+	struct uclass *uc;
+
+	uclass_id_foreach_dev(UCLASS_ETH, dev, uc) {
+		stats = eth_get_stats(dev);
+		if (!stats)
+			continue;
+		printf("eth%d : %s\n", dev_seq(dev), dev->name);
+		printf("  rx: %lu packets, %lu bytes, %lu errors, %lu dropped, %lu overruns\n",
+		       stats->rx_packets, stats->rx_bytes, stats->rx_errors,
+		       stats->rx_dropped, stats->rx_overruns);
+		printf("      %lu polls, %lu full batches\n", stats->rx_polls,
+		       stats->rx_full_batches);
+		printf("  tx: %lu packets, %lu errors\n", stats->tx_packets,
+		       stats->tx_errors);
+	}
+	return CMD_RET_SUCCESS;
+}
+
 static struct cmd_tbl cmd_net[] = {
 	U_BOOT_CMD_MKENT(list, 1, 0, do_net_list, "", ""),
+	U_BOOT_CMD_MKENT(stats, 1, 0, do_net_stats, "", ""),
 };
 
 static int do_net(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
@@ -673,6 +696,7 @@ U_BOOT_CMD(
 	net, 2, 1, do_net,
 	"NET sub-system",
 	"list - list available devices\n"
+	"net stats - show statistics of probed devices\n"
 );
 
 #if defined(CONFIG_CMD_NCSI)
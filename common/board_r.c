@@ -241,6 +241,12 @@ static int initr_dm(void)
 	gd->dm_root = NULL;
 #ifdef CONFIG_TIMER
 	gd->timer = NULL;
+#endif
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+	gd->dm_compat = NULL;
+#endif
+#if CONFIG_IS_ENABLED(OFNODE_PROP_CACHE)
+	gd->ofnode_prop_cache = NULL;
 #endif
 	bootstage_start(BOOTSTAGE_ID_ACCUM_DM_R, "dm_r");
 	ret = dm_init_and_scan(false);
@@ -218,6 +218,27 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+uint32_t bootstage_add_accum(const char *name, ulong start_us,
+			     uint32_t duration_us)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_record *rec;
+
+	if (!data)
+		return duration_us;
+	rec = ensure_id(data, data->next_id++);
+	if (!rec) {
+		log_warning("Bootstage space exhausted\n");
+		return duration_us;
+	}
+	rec->name = name;
+	/* a start time marks this as an accumulated-time record */
+	rec->start_us = start_us ? start_us : 1;
+	rec->time_us = duration_us;
+
+	return duration_us;
+}
+
 /**
  * Get a record name as a printable string
  *
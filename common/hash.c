@@ -13,6 +13,7 @@
 #include <common.h>
 #include <command.h>
 #include <env.h>
+#include <hexdump.h>
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
@@ -433,6 +434,121 @@ int hash_block(const char *algo_name, const void *data, unsigned int len,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(HASH_LOAD)
+/**
+ * struct hash_load - State for hashing a file while it is loaded
+ *
+ * @algo: Hash algorithm, or NULL if not hashing
+ * @ctx: Progressive hash context
+ * @addr: Address the file is being loaded to
+ * @done: Number of bytes hashed so far, from the start of the file
+ */
+static struct hash_load {
+	struct hash_algo *algo;
+	void *ctx;
+	ulong addr;
+	ulong done;
+} hash_load;
+
+void hash_load_abort(void)
+{
+	if (hash_load.algo)
+		free(hash_load.ctx);
+	hash_load.algo = NULL;
+}
+
+int hash_load_start(ulong addr)
+{
+	struct hash_algo *algo;
+	const char *name;
+	int ret;
+
+	hash_load_abort();
+	env_set("filehash", NULL);
+	name = env_get("loadhash");
+	if (!name)
+		return 0;
+
+	ret = hash_progressive_lookup_algo(name, &algo);
+	if (ret) {
+		printf("Unknown hash algorithm '%s' in loadhash\n", name);
+		return ret;
+	}
+	ret = algo->hash_init(algo, &hash_load.ctx);
+	if (ret)
+		return ret;
+	hash_load.algo = algo;
+	hash_load.addr = addr;
+	hash_load.done = 0;
+
+	return 0;
+}
+
+void hash_load_update(ulong offset, const void *buf, ulong len)
+{
+	struct hash_algo *algo = hash_load.algo;
+	ulong skip;
+
+	/*
+	 * Data which arrives ahead of a gap is hashed from memory once the
+	 * load is complete. Data which arrives twice is only hashed once.
+	 */
+	if (!algo || offset > hash_load.done || offset + len <= hash_load.done)
+		return;
+	skip = hash_load.done - offset;
+	if (algo->hash_update(algo, hash_load.ctx, buf + skip, len - skip, 0)) {
+		hash_load_abort();
+		return;
+	}
+	hash_load.done += len - skip;
+}
+
+int hash_load_finish(ulong size)
+{
+	uint8_t output[HASH_MAX_DIGEST_SIZE];
+	char str[HASH_MAX_DIGEST_SIZE * 2 + 1];
+	struct hash_algo *algo = hash_load.algo;
+	const void *buf, *ptr;
+	ulong len;
+	int ret;
+
+	if (!algo)
+		return 0;
+	if (size < hash_load.done) {
+		hash_load_abort();
+		return -EINVAL;
+	}
+
+	/* hash anything which was not hashed as it arrived */
+	len = size - hash_load.done;
+	buf = map_sysmem(hash_load.addr + hash_load.done, len);
+	ptr = buf;
+	do {
+		uint chunk = min_t(ulong, len, algo->chunk_size);
+
+		ret = algo->hash_update(algo, hash_load.ctx, ptr, chunk,
+					chunk == len);
+		ptr += chunk;
+		len -= chunk;
+		schedule();
+	} while (!ret && len);
+	unmap_sysmem(buf);
+	if (ret) {
+		hash_load_abort();
+		return ret;
+	}
+
+	hash_load.algo = NULL;
+	ret = algo->hash_finish(algo, hash_load.ctx, output, sizeof(output));
+	if (ret)
+		return ret;
+	*bin2hex(str, output, algo->digest_size) = '\0';
+	printf("%s ==> %s\n", algo->name, str);
+
+	return env_set("filehash", str);
+}
+#endif /* HASH_LOAD */
+
 #if !defined(CONFIG_SPL_BUILD) && (defined(CONFIG_CMD_HASH) || \
 	defined(CONFIG_CMD_SHA1SUM) || defined(CONFIG_CMD_CRC32))
 /**
@@ -18,6 +18,7 @@
 #include <net.h>
 #include <version_string.h>
 #include <efi_loader.h>
+#include <dm/root.h>
 
 static void run_preboot_environment_command(void)
 {
@@ -43,6 +44,7 @@ void main_loop(void)
 	const char *s;
 
 	bootstage_mark_name(BOOTSTAGE_ID_MAIN_LOOP, "main_loop");
+	dm_timing_bootstage();
 
 	if (IS_ENABLED(CONFIG_VERSION_VARIABLE))
 		env_set("ver", version_string);  /* set version variable */
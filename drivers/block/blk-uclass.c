@@ -8,9 +8,11 @@
 
 #include <common.h>
 #include <blk.h>
+#include <cyclic.h>
 #include <dm.h>
 #include <log.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <part.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -444,6 +446,47 @@ int blk_get_device(int uclass_id, int devnum, struct udevice **devp)
 	return device_probe(*devp);
 }
 
+/**
+ * blk_read_ahead() - read more blocks than requested, to fill the cache
+ *
+ * @dev: Device to read from
+ * @start: Start block for the read
+ * @blkcnt: Number of blocks requested
+ * @buf: Place to put the requested blocks
+ * Return: true if the requested blocks were read, false if the caller should
+ * read them itself
+ */
+static bool blk_read_ahead(struct udevice *dev, lbaint_t start,
+			   lbaint_t blkcnt, void *buf)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	lbaint_t count;
+	void *ra_buf;
+	bool ok;
+
+	count = blkcache_readahead(desc->uclass_id, desc->devnum, start,
+				   blkcnt);
+	if (start + count > desc->lba)
+		count = desc->lba > start ? desc->lba - start : 0;
+	if (count <= blkcnt)
+		return false;
+
+	ra_buf = malloc_cache_aligned(count * desc->blksz);
+	if (!ra_buf)
+		return false;
+
+	ok = ops->read(dev, start, count, ra_buf) == count;
+	if (ok) {
+		blkcache_fill(desc->uclass_id, desc->devnum, start, count,
+			      desc->blksz, ra_buf);
+		memcpy(buf, ra_buf, blkcnt * desc->blksz);
+	}
+	free(ra_buf);
+
+	return ok;
+}
+
 long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
 {
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
@@ -456,6 +499,8 @@ long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
 	if (blkcache_read(desc->uclass_id, desc->devnum,
 			  start, blkcnt, desc->blksz, buf))
 		return blkcnt;
+	if (blk_read_ahead(dev, start, blkcnt, buf))
+		return blkcnt;
 	blks_read = ops->read(dev, start, blkcnt, buf);
 	if (blks_read == blkcnt)
 		blkcache_fill(desc->uclass_id, desc->devnum, start, blkcnt,
@@ -491,6 +536,103 @@ long blk_erase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
 	return ops->erase(dev, start, blkcnt);
 }
 
+lbaint_t blk_request_blkcnt(const struct blk_request *req)
+{
+	lbaint_t blkcnt = 0;
+	uint i;
+
+	for (i = 0; i < req->sg_count; i++)
+		blkcnt += req->sg[i].blkcnt;
+
+	return blkcnt;
+}
+
+void blk_request_done(struct blk_request *req, lbaint_t blkcnt, int status)
+{
+	if (!status && blkcnt != blk_request_blkcnt(req))
+		status = -EIO;
+	req->blkcnt_done = blkcnt;
+	req->status = status;
+	if (req->complete)
+		req->complete(req);
+}
+
+/* Carry out a request using the synchronous read() and write() methods */
+static void blk_submit_sync(struct udevice *dev, struct blk_request *req)
+{
+	const struct blk_ops *ops = blk_get_ops(dev);
+	lbaint_t start = req->start, done = 0;
+	ulong ret;
+	uint i;
+
+	for (i = 0; i < req->sg_count; i++) {
+		struct blk_sg *sg = &req->sg[i];
+
+		if (req->op == BLK_REQ_WRITE)
+			ret = ops->write(dev, start, sg->blkcnt, sg->buf);
+		else
+			ret = ops->read(dev, start, sg->blkcnt, sg->buf);
+		if (IS_ERR_VALUE(ret)) {
+			blk_request_done(req, done, ret);
+			return;
+		}
+		done += ret;
+		if (ret != sg->blkcnt)
+			break;
+		start += ret;
+	}
+	blk_request_done(req, done, 0);
+}
+
+int blk_submit(struct udevice *dev, struct blk_request *req)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	int ret;
+
+	if (req->op == BLK_REQ_WRITE ? !ops->write : !ops->read)
+		return -ENOSYS;
+
+	req->dev = dev;
+	req->status = -EINPROGRESS;
+	req->blkcnt_done = 0;
+	if (req->op == BLK_REQ_WRITE)
+		blkcache_invalidate(desc->uclass_id, desc->devnum);
+
+	if (ops->submit) {
+		ret = ops->submit(dev, req);
+		if (ret != -ENOSYS)
+			return ret;
+	}
+	blk_submit_sync(dev, req);
+
+	return 0;
+}
+
+int blk_poll(struct udevice *dev)
+{
+	const struct blk_ops *ops = blk_get_ops(dev);
+
+	if (!ops->poll)
+		return 0;
+
+	return ops->poll(dev);
+}
+
+int blk_wait(struct blk_request *req)
+{
+	int ret;
+
+	while (req->status == -EINPROGRESS) {
+		ret = blk_poll(req->dev);
+		if (ret < 0)
+			return ret;
+		schedule();
+	}
+
+	return req->status;
+}
+
 ulong blk_dread(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt,
 		void *buffer)
 {
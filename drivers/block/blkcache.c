@@ -11,27 +11,83 @@
 #include <part.h>
 #include <asm/global_data.h>
 #include <linux/ctype.h>
+#include <linux/kernel.h>
 #include <linux/list.h>
+#include <linux/log2.h>
 
 #ifdef CONFIG_NEEDS_MANUAL_RELOC
 DECLARE_GLOBAL_DATA_PTR;
 #endif
 
+/* Number of hash buckets used to look up cache lines */
+#define BLKCACHE_HASH_BITS	6
+#define BLKCACHE_HASH_SIZE	(1 << BLKCACHE_HASH_BITS)
+
+/* Largest cache line supported, limited by the size of the valid bitmap */
+#define BLKCACHE_MAX_LINE_BLOCKS	64
+
+/*
+ * struct block_cache_node - a cache line
+ *
+ * Each line holds up to max_blocks_per_entry blocks of a device, starting at
+ * a block number which is a multiple of the line size (a power of two).
+ * Blocks are filled in individually, so @valid records which of them hold
+ * data.
+ *
+ * @lh: entry in the LRU list, most recently used first
+ * @hn: entry in the hash chain
+ * @iftype: uclass ID of the device
+ * @devnum: device number within that uclass
+ * @start: first block covered by this line
+ * @blksz: block size in bytes
+ * @valid: bit n is set if block @start + n is present
+ * @cache: cached data, max_blocks_per_entry * @blksz bytes
+ */
 struct block_cache_node {
 	struct list_head lh;
+	struct hlist_node hn;
 	int iftype;
 	int devnum;
 	lbaint_t start;
-	lbaint_t blkcnt;
 	unsigned long blksz;
+	u64 valid;
 	char *cache;
 };
 
+/*
+ * struct block_cache_dev - per-device state of the cache
+ *
+ * @lh: entry in the block_cache_devs list
+ * @iftype: uclass ID of the device
+ * @devnum: device number within that uclass
+ * @next: block following the last one read, to detect sequential access
+ * @seq: true if the last read started at the end of the one before it
+ * @window: current readahead window in blocks, 0 if not reading ahead
+ * @hits: number of reads satisfied from the cache
+ * @misses: number of reads passed on to the device
+ * @readaheads: number of reads enlarged to fill the cache ahead of use
+ */
+struct block_cache_dev {
+	struct list_head lh;
+	int iftype;
+	int devnum;
+	lbaint_t next;
+	bool seq;
+	lbaint_t window;
+	unsigned hits;
+	unsigned misses;
+	unsigned readaheads;
+};
+
 static LIST_HEAD(block_cache);
+static LIST_HEAD(block_cache_devs);
+static struct hlist_head block_cache_hash[BLKCACHE_HASH_SIZE];
 
 static struct block_cache_stats _stats = {
 	.max_blocks_per_entry = 8,
-	.max_entries = 32
+	.max_entries = CONFIG_VAL(BLOCK_CACHE_SIZE) / (8 * 512),
+	.max_size = CONFIG_VAL(BLOCK_CACHE_SIZE),
+	.readahead_blocks = CONFIG_VAL(BLOCK_CACHE_READAHEAD),
 };
 
 #ifdef CONFIG_NEEDS_MANUAL_RELOC
@@ -42,22 +98,68 @@ int blkcache_init(void)
 	head->next = (uintptr_t)head->next + gd->reloc_off;
 	head->prev = (uintptr_t)head->prev + gd->reloc_off;
 
+	head = &block_cache_devs;
+	head->next = (uintptr_t)head->next + gd->reloc_off;
+	head->prev = (uintptr_t)head->prev + gd->reloc_off;
+
 	return 0;
 }
 #endif
 
+/* First block of the line holding block @start */
+static lbaint_t cache_line(lbaint_t start)
+{
+	return start & ~(lbaint_t)(_stats.max_blocks_per_entry - 1);
+}
+
+static struct hlist_head *cache_bucket(int iftype, int devnum,
+				       lbaint_t start)
+{
+	u32 key;
+
+	key = (u32)(start >> ilog2(_stats.max_blocks_per_entry)) * 0x9e3779b1;
+	key ^= (iftype << 8 | devnum) * 0x85ebca6b;
+
+	return &block_cache_hash[key >> (32 - BLKCACHE_HASH_BITS)];
+}
+
+static struct block_cache_dev *cache_dev(int iftype, int devnum, bool create)
+{
+	struct block_cache_dev *bdev;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh)
+		if (bdev->iftype == iftype && bdev->devnum == devnum)
+			return bdev;
+
+	if (!create)
+		return NULL;
+
+	bdev = calloc(1, sizeof(*bdev));
+	if (!bdev)
+		return NULL;
+	bdev->iftype = iftype;
+	bdev->devnum = devnum;
+	list_add_tail(&bdev->lh, &block_cache_devs);
+
+	return bdev;
+}
+
+/*
+ * cache_find() - find the line holding a block
+ *
+ * @start must be the first block of a line. The line is moved to the front of
+ * the LRU list if found.
+ */
 static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
+					   lbaint_t start, unsigned long blksz)
 {
 	struct block_cache_node *node;
 
-	list_for_each_entry(node, &block_cache, lh)
+	hlist_for_each_entry(node, cache_bucket(iftype, devnum, start), hn)
 		if ((node->iftype == iftype) &&
 		    (node->devnum == devnum) &&
 		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
+		    (node->start == start)) {
 			if (block_cache.next != &node->lh) {
 				/* maintain MRU ordering */
 				list_del(&node->lh);
@@ -65,103 +167,245 @@ static struct block_cache_node *cache_find(int iftype, int devnum,
 			}
 			return node;
 		}
-	return 0;
+	return NULL;
+}
+
+static void cache_drop(struct block_cache_node *node)
+{
+	list_del(&node->lh);
+	hlist_del(&node->hn);
+	_stats.entries--;
+	_stats.size -= _stats.max_blocks_per_entry * node->blksz;
+	debug("drop: start " LBAF "\n", node->start);
+}
+
+/* Largest read which is stored in the cache */
+static lbaint_t cache_max_fill(void)
+{
+	return max(_stats.max_blocks_per_entry, _stats.readahead_blocks);
+}
+
+/*
+ * cache_mask() - get the bits in a line's valid map for a range of blocks
+ *
+ * @line: first block of the line
+ * @start: first block wanted
+ * @end: block after the last one wanted
+ * Return: mask for the part of the range which falls in the line
+ */
+static u64 cache_mask(lbaint_t line, lbaint_t start, lbaint_t end)
+{
+	lbaint_t first = max(line, start) - line;
+	lbaint_t last = min(line + _stats.max_blocks_per_entry, end) - line;
+
+	if (last - first == 64)
+		return ~0ULL;
+
+	return ((1ULL << (last - first)) - 1) << first;
 }
 
 int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
-		debug("hit: start " LBAF ", count " LBAFU "\n",
-		      start, blkcnt);
-		++_stats.hits;
-		return 1;
+	const lbaint_t line_blocks = _stats.max_blocks_per_entry;
+	struct block_cache_dev *bdev;
+	struct block_cache_node *node;
+	lbaint_t line, end = start + blkcnt;
+
+	bdev = cache_dev(iftype, devnum, true);
+	if (bdev) {
+		bdev->seq = start == bdev->next;
+		bdev->next = end;
+	}
+
+	if (blkcnt > cache_max_fill() || !_stats.entries)
+		goto miss;
+
+	/* check that every block is present before copying anything */
+	for (line = cache_line(start); line < end;
+	     line += line_blocks) {
+		u64 mask = cache_mask(line, start, end);
+
+		node = cache_find(iftype, devnum, line, blksz);
+		if (!node || (node->valid & mask) != mask)
+			goto miss;
 	}
 
+	for (line = cache_line(start); line < end;
+	     line += line_blocks) {
+		lbaint_t first = max(line, start);
+		lbaint_t last = min(line + line_blocks, end);
+
+		node = cache_find(iftype, devnum, line, blksz);
+		memcpy(buffer + (first - start) * blksz,
+		       node->cache + (first - line) * blksz,
+		       (last - first) * blksz);
+	}
+
+	debug("hit: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
+	++_stats.hits;
+	if (bdev)
+		bdev->hits++;
+	return 1;
+
+miss:
 	debug("miss: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 	++_stats.misses;
+	if (bdev)
+		bdev->misses++;
 	return 0;
 }
 
+lbaint_t blkcache_readahead(int iftype, int devnum,
+			    lbaint_t start, lbaint_t blkcnt)
+{
+	const lbaint_t line_blocks = _stats.max_blocks_per_entry;
+	struct block_cache_dev *bdev;
+	lbaint_t count, end;
+
+	if (blkcnt >= _stats.readahead_blocks || !_stats.max_entries)
+		return blkcnt;
+
+	bdev = cache_dev(iftype, devnum, false);
+	if (!bdev)
+		return blkcnt;
+
+	/* only read ahead once the access pattern looks sequential */
+	if (!bdev->seq) {
+		bdev->window = 0;
+		return blkcnt;
+	}
+
+	/* start with a few lines and double up to the configured maximum */
+	if (!bdev->window)
+		bdev->window = max(blkcnt * 4, line_blocks);
+	else
+		bdev->window *= 2;
+	bdev->window = min(bdev->window, (lbaint_t)_stats.readahead_blocks);
+	count = max(blkcnt, bdev->window);
+
+	/* end on a line boundary so that the next read is a whole line */
+	end = start + count;
+	if (cache_line(end) > start + blkcnt)
+		count = cache_line(end) - start;
+
+	if (count > blkcnt) {
+		debug("readahead: start " LBAF ", count " LBAFU "\n",
+		      start, count);
+		bdev->readaheads++;
+		_stats.readaheads++;
+	}
+
+	return count;
+}
+
 void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
+	const lbaint_t line_blocks = _stats.max_blocks_per_entry;
+	const unsigned long line_bytes = line_blocks * blksz;
 	struct block_cache_node *node;
+	lbaint_t line, end = start + blkcnt;
 
 	/* don't cache big stuff */
-	if (blkcnt > _stats.max_blocks_per_entry)
+	if (blkcnt > cache_max_fill())
 		return;
 
-	if (_stats.max_entries == 0)
+	if (_stats.max_entries == 0 || _stats.max_size < line_bytes)
 		return;
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
-		}
-	} else {
-		node = malloc(sizeof(*node));
-		if (!node)
-			return;
-		node->cache = 0;
-	}
+	for (line = cache_line(start); line < end;
+	     line += line_blocks) {
+		lbaint_t first = max(line, start);
+		lbaint_t last = min(line + line_blocks, end);
 
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
-		}
-	}
+		node = cache_find(iftype, devnum, line, blksz);
+		if (!node) {
+			while (_stats.entries &&
+			       (_stats.max_entries <= _stats.entries ||
+				_stats.max_size < _stats.size + line_bytes)) {
+				/* pop LRU, keeping the last one for reuse */
+				if (node) {
+					free(node->cache);
+					free(node);
+				}
+				node = list_last_entry(&block_cache,
+						       struct block_cache_node,
+						       lh);
+				cache_drop(node);
+			}
+			if (node && node->blksz != blksz) {
+				free(node->cache);
+				node->cache = NULL;
+			}
+			if (!node) {
+				node = malloc(sizeof(*node));
+				if (!node)
+					return;
+				node->cache = NULL;
+			}
+			if (!node->cache) {
+				node->cache = malloc(line_bytes);
+				if (!node->cache) {
+					free(node);
+					return;
+				}
+			}
 
-	debug("fill: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
+			node->iftype = iftype;
+			node->devnum = devnum;
+			node->start = line;
+			node->blksz = blksz;
+			node->valid = 0;
+			list_add(&node->lh, &block_cache);
+			hlist_add_head(&node->hn,
+				       cache_bucket(iftype, devnum, line));
+			_stats.entries++;
+			_stats.size += line_bytes;
+		}
 
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
+		debug("fill: start " LBAF ", count " LBAFU "\n",
+		      first, last - first);
+		memcpy(node->cache + (first - line) * blksz,
+		       buffer + (first - start) * blksz,
+		       (last - first) * blksz);
+		node->valid |= cache_mask(line, start, end);
+	}
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache_node *node, *n;
+	struct block_cache_dev *bdev;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
+	list_for_each_entry_safe(node, n, &block_cache, lh) {
 		if (iftype == -1 ||
 		    (node->iftype == iftype && node->devnum == devnum)) {
-			list_del(entry);
+			cache_drop(node);
 			free(node->cache);
 			free(node);
-			--_stats.entries;
+		}
+	}
+
+	list_for_each_entry(bdev, &block_cache_devs, lh) {
+		if (iftype == -1 ||
+		    (bdev->iftype == iftype && bdev->devnum == devnum)) {
+			bdev->next = 0;
+			bdev->seq = false;
+			bdev->window = 0;
 		}
 	}
 }
 
 void blkcache_configure(unsigned blocks, unsigned entries)
 {
+	blocks = clamp(blocks, 1U, (unsigned)BLKCACHE_MAX_LINE_BLOCKS);
+	blocks = rounddown_pow_of_two(blocks);
+
 	/* invalidate cache if there is a change */
 	if ((blocks != _stats.max_blocks_per_entry) ||
 	    (entries != _stats.max_entries))
@@ -172,6 +416,16 @@ void blkcache_configure(unsigned blocks, unsigned entries)
 
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.readaheads = 0;
+}
+
+void blkcache_configure_size(unsigned long size, unsigned readahead)
+{
+	if (size != _stats.max_size)
+		blkcache_invalidate(-1, 0);
+
+	_stats.max_size = size;
+	_stats.readahead_blocks = readahead;
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
@@ -179,9 +433,38 @@ void blkcache_stats(struct block_cache_stats *stats)
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.readaheads = 0;
+}
+
+int blkcache_dev_stats(int index, struct block_cache_dev_stats *stats)
+{
+	struct block_cache_dev *bdev;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh) {
+		if (index--)
+			continue;
+		stats->iftype = bdev->iftype;
+		stats->devnum = bdev->devnum;
+		stats->hits = bdev->hits;
+		stats->misses = bdev->misses;
+		stats->readaheads = bdev->readaheads;
+		bdev->hits = 0;
+		bdev->misses = 0;
+		bdev->readaheads = 0;
+
+		return 0;
+	}
+
+	return -ENOENT;
 }
 
 void blkcache_free(void)
 {
+	struct block_cache_dev *bdev, *n;
+
 	blkcache_invalidate(-1, 0);
+	list_for_each_entry_safe(bdev, n, &block_cache_devs, lh) {
+		list_del(&bdev->lh);
+		free(bdev);
+	}
 }
@@ -204,6 +204,11 @@ int device_remove(struct udevice *dev, uint flags)
 	if (!dev)
 		return -EINVAL;
 
+	/* Let the device settle first; if it fails it is not active anyway */
+	if (CONFIG_IS_ENABLED(DM_ASYNC_PROBE) &&
+	    (dev_get_flags(dev) & DM_FLAG_PROBE_PENDING))
+		device_probe(dev);
+
 	if (!(dev_get_flags(dev) & DM_FLAG_ACTIVATED))
 		return 0;
 
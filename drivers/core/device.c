@@ -9,12 +9,14 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <cpu_func.h>
 #include <event.h>
 #include <log.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
 #include <clk.h>
+#include <cyclic.h>
 #include <fdtdec.h>
 #include <fdt_support.h>
 #include <malloc.h>
@@ -36,11 +38,73 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/**
+ * struct dm_timing - timing of a device bind or probe (CONFIG_DM_TIMING)
+ *
+ * Time spent binding and probing other devices meanwhile, e.g. a parent
+ * probed by device_probe(), is added up in gd->dm_timing_nested so that it
+ * can be left out of the device's own time.
+ *
+ * @start_us: Boot time at the start, or 0 if not timed
+ * @nested_us: Nested time of the caller, restored at the end
+ */
+struct dm_timing {
+	ulong start_us;
+	ulong nested_us;
+};
+
+static void dm_timing_start(struct dm_timing *timing)
+{
+	timing->start_us = 0;
+#if CONFIG_IS_ENABLED(DM_TIMING)
+#if CONFIG_IS_ENABLED(TIMER) && !IS_ENABLED(CONFIG_TIMER_EARLY)
+	/* reading the time before the timer is ready would probe it */
+	if (!gd->timer)
+		return;
+#endif
+	timing->nested_us = gd->dm_timing_nested;
+	gd->dm_timing_nested = 0;
+	timing->start_us = timer_get_boot_us();
+#endif
+}
+
+/**
+ * dm_timing_end() - finish timing a bind or probe
+ *
+ * @timing: Timing started by dm_timing_start()
+ * @dev: Device to update, or NULL if it is gone
+ * @probe: true to record a probe, false to record a bind
+ */
+static void dm_timing_end(struct dm_timing *timing, struct udevice *dev,
+			  bool probe)
+{
+#if CONFIG_IS_ENABLED(DM_TIMING)
+	ulong total, self;
+
+	if (!timing->start_us)
+		return;
+	total = timer_get_boot_us() - timing->start_us;
+	self = total - gd->dm_timing_nested;
+	gd->dm_timing_nested = timing->nested_us + total;
+	if (!dev)
+		return;
+
+	if (!probe) {
+		dev->bind_us = self;
+	} else if (!dev->probe_start_us) {
+		dev->probe_start_us = timing->start_us;
+		dev->probe_us = total;
+		dev->probe_self_us = self;
+	}
+#endif
+}
+
 static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			      const char *name, void *plat,
 			      ulong driver_data, ofnode node,
 			      uint of_plat_size, struct udevice **devp)
 {
+	struct dm_timing timing;
 	struct udevice *dev;
 	struct uclass *uc;
 	int size, ret = 0;
@@ -64,6 +128,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	dev = calloc(1, sizeof(struct udevice));
 	if (!dev)
 		return -ENOMEM;
+	dm_timing_start(&timing);
 
 	INIT_LIST_HEAD(&dev->sibling_node);
 	INIT_LIST_HEAD(&dev->child_head);
@@ -186,6 +251,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		*devp = dev;
 
 	dev_or_flags(dev, DM_FLAG_BOUND);
+	dm_timing_end(&timing, dev, false);
 
 	return 0;
 
@@ -232,6 +298,7 @@ fail_alloc1:
 	devres_release_all(dev);
 
 	free(dev);
+	dm_timing_end(&timing, NULL, false);
 
 	return ret;
 }
@@ -477,16 +544,175 @@ static int device_get_dma_constraints(struct udevice *dev)
 	return 0;
 }
 
-int device_probe(struct udevice *dev)
+/*
+ * The rest of probing, once the driver's probe() method has finished. If this
+ * fails the device is removed again.
+ */
+static int device_probe_finish(struct udevice *dev)
 {
-	const struct driver *drv;
 	int ret;
 
-	if (!dev)
-		return -EINVAL;
+	ret = uclass_post_probe_device(dev);
+	if (ret)
+		goto fail_uclass;
+
+	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL) {
+		ret = pinctrl_select_state(dev, "default");
+		if (ret && ret != -ENOSYS)
+			log_debug("Device '%s' failed to configure default pinctrl: %d (%s)\n",
+				  dev->name, ret, errno_str(ret));
+	}
+
+	ret = device_notify(dev, EVT_DM_POST_PROBE);
+	if (ret)
+		return ret;
+
+	return 0;
+fail_uclass:
+	if (device_remove(dev, DM_REMOVE_NORMAL)) {
+		dm_warn("%s: Device '%s' failed to remove on error path\n",
+			__func__, dev->name);
+	}
+	dev_bic_flags(dev, DM_FLAG_ACTIVATED);
+
+	device_free(dev);
+
+	return ret;
+}
+
+#if CONFIG_IS_ENABLED(DM_ASYNC_PROBE)
+/**
+ * struct device_pending - A device which is settling after device_probe_start()
+ *
+ * @sibling: Next device in the list of pending devices
+ * @dev: Device whose probe_complete() is to be polled
+ */
+struct device_pending {
+	struct list_head sibling;
+	struct udevice *dev;
+};
+
+/* Only used after relocation, so this can live in BSS */
+static LIST_HEAD(device_pending_list);
+
+static int device_pending_add(struct udevice *dev)
+{
+	struct device_pending *pend;
+
+	pend = malloc(sizeof(*pend));
+	if (!pend)
+		return -ENOMEM;
+	pend->dev = dev;
+	list_add_tail(&pend->sibling, &device_pending_list);
+	dev_or_flags(dev, DM_FLAG_PROBE_PENDING);
+
+	return 0;
+}
+
+/* Drop a device from the list; this leaves DM_FLAG_PROBE_PENDING alone */
+static void device_pending_del(struct udevice *dev)
+{
+	struct device_pending *pend;
+
+	list_for_each_entry(pend, &device_pending_list, sibling) {
+		if (pend->dev == dev) {
+			list_del(&pend->sibling);
+			free(pend);
+			break;
+		}
+	}
+}
+
+/* Finish probing a device once probe_complete() has returned @ret */
+static int device_pending_done(struct udevice *dev, int ret)
+{
+	device_pending_del(dev);
+	dev_bic_flags(dev, DM_FLAG_PROBE_PENDING);
+	if (ret) {
+		log_debug("Device '%s' failed to settle: %d\n", dev->name, ret);
+		dev_bic_flags(dev, DM_FLAG_ACTIVATED);
+		device_free(dev);
+
+		return ret;
+	}
+
+	return device_probe_finish(dev);
+}
+
+/* Wait for a device to finish settling */
+static int device_pending_wait(struct udevice *dev)
+{
+	int ret;
+
+	while ((ret = dev->driver->probe_complete(dev)) == -EINPROGRESS)
+		schedule();
+
+	return device_pending_done(dev, ret);
+}
 
-	if (dev_get_flags(dev) & DM_FLAG_ACTIVATED)
+void device_probe_wait_all(void)
+{
+	struct device_pending *pend;
+	struct udevice *dev;
+	int ret;
+
+	while (!list_empty(&device_pending_list)) {
+		dev = NULL;
+		list_for_each_entry(pend, &device_pending_list, sibling) {
+			ret = pend->dev->driver->probe_complete(pend->dev);
+			if (ret != -EINPROGRESS) {
+				dev = pend->dev;
+				break;
+			}
+		}
+		if (!dev) {
+			schedule();
+			continue;
+		}
+
+		/* This may probe (and so drop) other pending devices */
+		device_pending_done(dev, ret);
+	}
+}
+
+/*
+ * Called after the driver's probe() method for drivers with
+ * DM_FLAG_ASYNC_PROBE. This returns -EINPROGRESS if the device has been left
+ * to settle in the background.
+ */
+static int device_probe_settle(struct udevice *dev, bool wait)
+{
+	const struct driver *drv = dev->driver;
+	int ret;
+
+	if (!drv->probe_complete)
 		return 0;
+	ret = drv->probe_complete(dev);
+	if (ret != -EINPROGRESS)
+		return ret;
+	if (!wait && (gd->flags & GD_FLG_RELOC) && !device_pending_add(dev))
+		return -EINPROGRESS;
+	while ((ret = drv->probe_complete(dev)) == -EINPROGRESS)
+		schedule();
+
+	return ret;
+}
+#else
+static inline int device_pending_wait(struct udevice *dev)
+{
+	return 0;
+}
+
+static inline int device_probe_settle(struct udevice *dev, bool wait)
+{
+	return 0;
+}
+#endif
+
+static int device_probe_run(struct udevice *dev, bool wait)
+{
+	const struct driver *drv;
+	int ret;
 
 	ret = device_notify(dev, EVT_DM_PRE_PROBE);
 	if (ret)
@@ -511,8 +737,12 @@ int device_probe(struct udevice *dev)
 		 * (e.g. PCI bridge devices). Test the flags again
 		 * so that we don't mess up the device.
 		 */
-		if (dev_get_flags(dev) & DM_FLAG_ACTIVATED)
+		if (dev_get_flags(dev) & DM_FLAG_ACTIVATED) {
+			if (wait &&
+			    (dev_get_flags(dev) & DM_FLAG_PROBE_PENDING))
+				return device_pending_wait(dev);
 			return 0;
+		}
 	}
 
 	dev_or_flags(dev, DM_FLAG_ACTIVATED);
@@ -585,27 +815,15 @@ int device_probe(struct udevice *dev)
 			goto fail;
 	}
 
-	ret = uclass_post_probe_device(dev);
-	if (ret)
-		goto fail_uclass;
-
-	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL) {
-		ret = pinctrl_select_state(dev, "default");
-		if (ret && ret != -ENOSYS)
-			log_debug("Device '%s' failed to configure default pinctrl: %d (%s)\n",
-				  dev->name, ret, errno_str(ret));
+	if (drv->flags & DM_FLAG_ASYNC_PROBE) {
+		ret = device_probe_settle(dev, wait);
+		if (ret == -EINPROGRESS)
+			return 0;
+		if (ret)
+			goto fail;
 	}
 
-	ret = device_notify(dev, EVT_DM_POST_PROBE);
-	if (ret)
-		return ret;
-
-	return 0;
-fail_uclass:
-	if (device_remove(dev, DM_REMOVE_NORMAL)) {
-		dm_warn("%s: Device '%s' failed to remove on error path\n",
-			__func__, dev->name);
-	}
+	return device_probe_finish(dev);
 fail:
 	dev_bic_flags(dev, DM_FLAG_ACTIVATED);
 
@@ -614,6 +832,41 @@ fail:
 	return ret;
 }
 
+static int device_probe_common(struct udevice *dev, bool wait)
+{
+	struct dm_timing timing;
+	int ret;
+
+	if (!dev)
+		return -EINVAL;
+
+	if (dev_get_flags(dev) & DM_FLAG_ACTIVATED) {
+		if (wait && (dev_get_flags(dev) & DM_FLAG_PROBE_PENDING))
+			return device_pending_wait(dev);
+		return 0;
+	}
+
+	dm_timing_start(&timing);
+#if CONFIG_IS_ENABLED(DM_TIMING)
+	/* this is set again if the device is probed along with its parent */
+	dev->probe_start_us = 0;
+#endif
+	ret = device_probe_run(dev, wait);
+	dm_timing_end(&timing, dev, true);
+
+	return ret;
+}
+
+int device_probe(struct udevice *dev)
+{
+	return device_probe_common(dev, true);
+}
+
+int device_probe_start(struct udevice *dev)
+{
+	return device_probe_common(dev, false);
+}
+
 void *dev_get_plat(const struct udevice *dev)
 {
 	if (!dev) {
@@ -1136,6 +1389,20 @@ void device_set_name_alloced(struct udevice *dev)
 	dev_or_flags(dev, DM_FLAG_NAME_ALLOCED);
 }
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+void device_set_ofnode(struct udevice *dev, ofnode node)
+{
+	dev_set_ofnode(dev, node);
+	uclass_reindex_device(dev);
+}
+
+void device_set_seq(struct udevice *dev, int seq)
+{
+	dev->seq_ = seq;
+	uclass_reindex_device(dev);
+}
+#endif
+
 int device_set_name(struct udevice *dev, const char *name)
 {
 	name = strdup(name);
@@ -11,6 +11,10 @@
 #include <dm/root.h>
 #include <dm/util.h>
 #include <dm/uclass-internal.h>
+#include <asm/global_data.h>
+#include <linux/libfdt.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 /**
  * struct sort_info - information used for sorting
@@ -298,3 +302,115 @@ void dm_dump_mem(struct dm_stats *stats)
 	printf("Drop device name (not SRAM): %x (%d)\n", stats->dev_name_size,
 	       stats->dev_name_size);
 }
+
+void dm_dump_prop_stats(void)
+{
+	struct ofnode_prop_stats stats;
+	char path[256];
+	int i;
+
+	if (ofnode_get_prop_stats(&stats)) {
+		printf("No property lookups\n");
+		return;
+	}
+	printf("Property lookups %u, cache hits %u\n", stats.lookups,
+	       stats.hits);
+	printf("%8s  %8s  %s\n", "Lookups", "Hits", "Node");
+	printf("%8s  %8s  %s\n", "--------", "--------", "----");
+	for (i = 0; i < stats.num_counts; i++) {
+		const struct ofnode_prop_count *count = &stats.count[i];
+
+		if (!count->lookups)
+			continue;
+		if (fdt_get_path(gd->fdt_blob, count->node, path, sizeof(path)))
+			snprintf(path, sizeof(path), "<offset %x>",
+				 count->node);
+		printf("%8u  %8u  %s\n", count->lookups, count->hits, path);
+	}
+	if (stats.untracked)
+		printf("%8u  %8s  <other nodes>\n", stats.untracked, "");
+}
+
+#if CONFIG_IS_ENABLED(DM_TIMING)
+static int dm_timing_collect(struct udevice *dev, struct udevice **devs,
+			     int count, ulong *bindp)
+{
+	struct udevice *child;
+
+	*bindp += dev->bind_us;
+	if (dev->probe_start_us)
+		devs[count++] = dev;
+	device_foreach_child(child, dev)
+		count = dm_timing_collect(child, devs, count, bindp);
+
+	return count;
+}
+
+static int h_cmp_probe_start(const void *d1, const void *d2)
+{
+	const struct udevice *dev1 = *(const struct udevice **)d1;
+	const struct udevice *dev2 = *(const struct udevice **)d2;
+
+	if (dev1->probe_start_us != dev2->probe_start_us)
+		return dev1->probe_start_us < dev2->probe_start_us ? -1 : 1;
+
+	/* a device probed by another can start with it, but ends sooner */
+	if (dev1->probe_us != dev2->probe_us)
+		return dev1->probe_us > dev2->probe_us ? -1 : 1;
+
+	return 0;
+}
+
+static int h_cmp_probe_self(const void *d1, const void *d2)
+{
+	const struct udevice *dev1 = *(const struct udevice **)d1;
+	const struct udevice *dev2 = *(const struct udevice **)d2;
+
+	if (dev1->probe_self_us != dev2->probe_self_us)
+		return dev1->probe_self_us > dev2->probe_self_us ? -1 : 1;
+
+	return 0;
+}
+
+void dm_dump_timing(bool sort)
+{
+	int dev_count, uclasses, count, depth, i;
+	ulong bind = 0, probe = 0;
+	struct udevice **devs;
+	ulong end[16];
+
+	if (!dm_root())
+		return;
+	dm_get_stats(&dev_count, &uclasses);
+	devs = calloc(dev_count, sizeof(struct udevice *));
+	if (!devs) {
+		printf("(out of memory)\n");
+		return;
+	}
+	count = dm_timing_collect(dm_root(), devs, 0, &bind);
+	qsort(devs, count, sizeof(struct udevice *),
+	      sort ? h_cmp_probe_self : h_cmp_probe_start);
+
+	printf("%10s  %8s  %8s  %-10s  %s\n", "Start us", "Probe", "Self",
+	       "Class", "Name");
+	printf("----------------------------------------------------------\n");
+	for (depth = 0, i = 0; i < count; i++) {
+		struct udevice *dev = devs[i];
+
+		probe += dev->probe_self_us;
+
+		/* indent devices probed while another one was probing */
+		while (depth && dev->probe_start_us >= end[depth - 1])
+			depth--;
+		printf("%10lu  %8lu  %8lu  %-10.10s  %*s%s\n",
+		       dev->probe_start_us, dev->probe_us, dev->probe_self_us,
+		       dev->uclass->uc_drv->name, sort ? 0 : depth * 2, "",
+		       dev->name);
+		if (!sort && depth < ARRAY_SIZE(end))
+			end[depth++] = dev->probe_start_us + dev->probe_us;
+	}
+	printf("\n%d devices probed in %lu us, %d devices bound in %lu us\n",
+	       count, probe, dev_count, bind);
+	free(devs);
+}
+#endif
@@ -11,6 +11,8 @@
 #include <common.h>
 #include <errno.h>
 #include <log.h>
+#include <malloc.h>
+#include <asm/global_data.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -19,6 +21,9 @@
 #include <dm/util.h>
 #include <fdtdec.h>
 #include <linux/compiler.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 struct driver *lists_driver_lookup_name(const char *name)
 {
@@ -181,11 +186,167 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
-		   struct driver *drv, bool pre_reloc_only)
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+#define COMPAT_SLOT_EMPTY	U32_MAX
+
+/**
+ * struct dm_compat_table - hash table of driver compatible strings
+ *
+ * Each used slot holds the index of a driver in the linker list in its upper
+ * 16 bits and the index of the entry in that driver's of_match table in the
+ * lower 16 bits. Collisions are resolved by linear probing. Only the first
+ * driver claiming a compatible string is entered, as that is the one a walk
+ * of the linker list would find.
+ *
+ * @mask: Number of slots - 1
+ * @slot: Slots, COMPAT_SLOT_EMPTY if unused
+ */
+struct dm_compat_table {
+	uint mask;
+	u32 slot[];
+};
+
+static uint compat_hash(const char *compat)
+{
+	uint hash = 2166136261U;
+
+	while (*compat)
+		hash = (hash ^ (u8)*compat++) * 16777619U;
+
+	return hash;
+}
+
+static const struct udevice_id *compat_slot_id(struct driver *driver,
+					       u32 slot)
+{
+	return &driver[slot >> 16].of_match[slot & 0xffff];
+}
+
+/**
+ * lists_compat_table() - get the compatible string table
+ *
+ * The table is built on first use, in each of the pre- and post-relocation
+ * phases.
+ *
+ * Return: table, or NULL if out of memory
+ */
+static struct dm_compat_table *lists_compat_table(void)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *of_match;
+	struct dm_compat_table *tab;
+	uint count = 0, size, pos;
+	int i, m;
+
+	if (gd->dm_compat)
+		return gd->dm_compat;
+
+	for (i = 0; i < n_ents; i++) {
+		for (of_match = driver[i].of_match; of_match &&
+		     of_match->compatible; of_match++)
+			count++;
+	}
+	size = roundup_pow_of_two(count * 2 + 1);
+	tab = malloc(sizeof(*tab) + size * sizeof(u32));
+	if (!tab)
+		return NULL;
+	tab->mask = size - 1;
+	memset(tab->slot, 0xff, size * sizeof(u32));
+
+	for (i = 0; i < n_ents; i++) {
+		of_match = driver[i].of_match;
+		for (m = 0; of_match && of_match[m].compatible; m++) {
+			pos = compat_hash(of_match[m].compatible) & tab->mask;
+			while (tab->slot[pos] != COMPAT_SLOT_EMPTY &&
+			       strcmp(compat_slot_id(driver,
+						     tab->slot[pos])->compatible,
+				      of_match[m].compatible))
+				pos = (pos + 1) & tab->mask;
+			if (tab->slot[pos] == COMPAT_SLOT_EMPTY)
+				tab->slot[pos] = i << 16 | m;
+		}
+	}
+	gd->dm_compat = tab;
+
+	return tab;
+}
+
+static struct driver *lists_compat_lookup(struct dm_compat_table *tab,
+					  const char *compat,
+					  const struct udevice_id **of_idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const struct udevice_id *id;
+	uint pos;
+
+	for (pos = compat_hash(compat) & tab->mask;
+	     tab->slot[pos] != COMPAT_SLOT_EMPTY;
+	     pos = (pos + 1) & tab->mask) {
+		id = compat_slot_id(driver, tab->slot[pos]);
+		if (!strcmp(id->compatible, compat)) {
+			*of_idp = id;
+			return driver + (tab->slot[pos] >> 16);
+		}
+	}
+
+	return NULL;
+}
+#else
+static struct dm_compat_table *lists_compat_table(void)
+{
+	return NULL;
+}
+
+static struct driver *lists_compat_lookup(struct dm_compat_table *tab,
+					  const char *compat,
+					  const struct udevice_id **of_idp)
+{
+	return NULL;
+}
+#endif
+
+/**
+ * lists_find_compat() - find the driver to bind for a compatible string
+ *
+ * @drv: Only consider this driver, or NULL for any
+ * @compat: Compatible string to look for
+ * @of_idp: Returns the matching of_match entry, or NULL if @drv has no
+ *	of_match table
+ * Return: driver, or NULL if none matches
+ */
+static struct driver *lists_find_compat(struct driver *drv, const char *compat,
+					const struct udevice_id **of_idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct dm_compat_table *tab;
+	struct driver *entry;
+
+	*of_idp = NULL;
+	if (!drv) {
+		tab = lists_compat_table();
+		if (tab)
+			return lists_compat_lookup(tab, compat, of_idp);
+	}
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (drv) {
+			if (drv != entry)
+				continue;
+			if (!entry->of_match)
+				return entry;
+		}
+		if (!driver_check_compatible(entry->of_match, of_idp, compat))
+			return entry;
+	}
+
+	return NULL;
+}
+
+int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
+		   struct driver *drv, bool pre_reloc_only)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
@@ -222,20 +383,8 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 		log_debug("   - attempt to match compatible string '%s'\n",
 			  compat);
 
-		id = NULL;
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			if (drv) {
-				if (drv != entry)
-					continue;
-				if (!entry->of_match)
-					break;
-			}
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		entry = lists_find_compat(drv, compat, &id);
+		if (!entry)
 			continue;
 
 		if (pre_reloc_only) {
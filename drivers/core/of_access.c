@@ -29,6 +29,7 @@
 #include <linux/ctype.h>
 #include <linux/err.h>
 #include <linux/ioport.h>
+#include <linux/log2.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -343,6 +344,237 @@ static struct device_node *__of_find_node_by_path(struct device_node *parent,
 #define for_each_property_of_node(dn, pp) \
 	for (pp = dn->properties; pp != NULL; pp = pp->next)
 
+#if CONFIG_IS_ENABLED(OF_LOOKUP_INDEX)
+/**
+ * struct of_index_name - Entry in the name table of the live-tree index
+ *
+ * @key:	Full path of the node, or alias name (which has no leading '/')
+ * @np:		Node that @key refers to
+ */
+struct of_index_name {
+	const char *key;
+	struct device_node *np;
+};
+
+/**
+ * struct of_index - Lookup tables for the control live tree
+ *
+ * Both tables use open addressing with linear probing. They have at least
+ * twice as many slots as entries, so a probe always ends at an empty slot.
+ * Where several nodes share a key, the first one in tree order is kept, as
+ * that is the one a walk of the tree finds.
+ *
+ * @root:	Root node of the indexed tree
+ * @mask:	Number of slots in each table, minus one
+ * @names:	Number of entries in @name
+ * @phandle:	Nodes which have a phandle, keyed by that phandle
+ * @name:	Nodes keyed by full path and by alias
+ */
+struct of_index {
+	struct device_node *root;
+	uint mask;
+	uint names;
+	struct device_node **phandle;
+	struct of_index_name *name;
+};
+
+static struct of_index *of_index;
+
+static uint of_index_hash(const char *key, int len)
+{
+	uint hash = 2166136261U;
+
+	while (len--)
+		hash = (hash ^ (u8)*key++) * 16777619;
+
+	return hash;
+}
+
+/* Find the slot holding @key, or the empty slot where it would go */
+static struct of_index_name *of_index_slot(struct of_index *idx,
+					   const char *key, int len)
+{
+	struct of_index_name *ent;
+	uint i;
+
+	for (i = of_index_hash(key, len) & idx->mask;; i = (i + 1) & idx->mask) {
+		ent = &idx->name[i];
+		if (!ent->key || (!strncmp(ent->key, key, len) && !ent->key[len]))
+			return ent;
+	}
+}
+
+static int of_index_add_name(struct of_index *idx, const char *key,
+			     struct device_node *np)
+{
+	struct of_index_name *ent;
+
+	if (2 * (idx->names + 1) > idx->mask + 1)
+		return -ENOSPC;
+	ent = of_index_slot(idx, key, strlen(key));
+	if (!ent->key) {
+		ent->key = key;
+		ent->np = np;
+		idx->names++;
+	}
+
+	return 0;
+}
+
+static void of_index_add_phandle(struct of_index *idx, struct device_node *np)
+{
+	uint i;
+
+	/* dtc allocates phandles in sequence, so this rarely has to probe */
+	for (i = np->phandle & idx->mask; idx->phandle[i];
+	     i = (i + 1) & idx->mask) {
+		if (idx->phandle[i]->phandle == np->phandle)
+			return;
+	}
+	idx->phandle[i] = np;
+}
+
+static struct device_node *of_index_find_phandle(struct of_index *idx,
+						 phandle handle)
+{
+	struct device_node *np;
+	uint i;
+
+	for (i = handle & idx->mask; (np = idx->phandle[i]);
+	     i = (i + 1) & idx->mask) {
+		if (np->phandle == handle)
+			break;
+	}
+
+	return np;
+}
+
+int of_index_build(struct device_node *root)
+{
+	struct device_node *np, *aliases;
+	struct property *pp;
+	struct of_index *idx;
+	uint count, size;
+	int ret;
+
+	free(of_index);
+	of_index = NULL;
+
+	/* Leave room for the aliases too */
+	count = 1;
+	for (np = root->child; np; np = of_find_all_nodes(np))
+		count++;
+	aliases = NULL;
+	for (np = root->child; np; np = np->sibling) {
+		if (!strcmp(np->full_name, "/aliases")) {
+			aliases = np;
+			for_each_property_of_node(np, pp)
+				count++;
+			break;
+		}
+	}
+
+	size = roundup_pow_of_two(2 * count + 2);
+	idx = calloc(1, sizeof(*idx) + size * (sizeof(*idx->phandle) +
+					       sizeof(*idx->name)));
+	if (!idx)
+		return -ENOMEM;
+	idx->root = root;
+	idx->mask = size - 1;
+	idx->name = (struct of_index_name *)(idx + 1);
+	idx->phandle = (struct device_node **)(idx->name + size);
+
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		ret = of_index_add_name(idx, np->full_name, np);
+		if (ret)
+			goto err;
+		if (np->phandle)
+			of_index_add_phandle(idx, np);
+	}
+
+	/* Aliases are only processed for the control FDT */
+	if (aliases && root == gd->of_root) {
+		for_each_property_of_node(aliases, pp) {
+			const char *path = pp->value;
+
+			if (!pp->length || *path != '/' ||
+			    strnlen(path, pp->length) == pp->length)
+				continue;
+			np = of_index_slot(idx, path, strlen(path))->np;
+			if (!np)
+				continue;
+			ret = of_index_add_name(idx, pp->name, np);
+			if (ret)
+				goto err;
+		}
+	}
+	of_index = idx;
+
+	return 0;
+err:
+	free(idx);
+
+	return ret;
+}
+
+/* Add a node created after the index was built */
+static void of_index_add_node(struct device_node *np)
+{
+	struct device_node *root;
+
+	if (!of_index)
+		return;
+	for (root = np; root->parent; root = root->parent)
+		;
+	if (root != of_index->root)
+		return;
+	if (of_index_add_name(of_index, np->full_name, np))
+		of_index_build(root);
+}
+
+/*
+ * Look up a full path in the index. This returns ERR_PTR(-ENOSYS) if @root
+ * is not indexed, or NULL if there is no such node.
+ */
+static struct device_node *of_index_find_path(struct device_node *root,
+					      const char *path,
+					      const char *separator)
+{
+	int len = separator ? separator - path : strlen(path);
+
+	if (!of_index || root != of_index->root || len < 2)
+		return ERR_PTR(-ENOSYS);
+
+	return of_index_slot(of_index, path, len)->np;
+}
+
+static struct device_node *of_index_find_alias(struct device_node *root,
+					       const char *name, int len)
+{
+	if (!of_index || root != of_index->root || !len)
+		return NULL;
+
+	return of_index_slot(of_index, name, len)->np;
+}
+#else
+static inline void of_index_add_node(struct device_node *np)
+{
+}
+
+static inline struct device_node *of_index_find_path(struct device_node *root,
+						     const char *path,
+						     const char *separator)
+{
+	return ERR_PTR(-ENOSYS);
+}
+
+static inline struct device_node *of_index_find_alias(struct device_node *root,
+						      const char *name, int len)
+{
+	return NULL;
+}
+#endif
+
 struct device_node *of_find_node_opts_by_path(struct device_node *root,
 					      const char *path,
 					      const char **opts)
@@ -375,11 +607,14 @@ struct device_node *of_find_node_opts_by_path(struct device_node *root,
 		if (!of_aliases)
 			return NULL;
 
-		for_each_property_of_node(of_aliases, pp) {
-			if (strlen(pp->name) == len && !strncmp(pp->name, path,
-								len)) {
-				np = of_find_node_by_path(pp->value);
-				break;
+		np = of_index_find_alias(root, path, len);
+		if (!np) {
+			for_each_property_of_node(of_aliases, pp) {
+				if (strlen(pp->name) == len &&
+				    !strncmp(pp->name, path, len)) {
+					np = of_find_node_by_path(pp->value);
+					break;
+				}
 			}
 		}
 		if (!np)
@@ -387,9 +622,14 @@ struct device_node *of_find_node_opts_by_path(struct device_node *root,
 		path = p;
 	}
 
-	/* Step down the tree matching path components */
-	if (!np)
+	if (!np) {
+		np = of_index_find_path(root, path, separator);
+		if (!IS_ERR(np))
+			return np;
 		np = of_node_get(root);
+	}
+
+	/* Step down the tree matching path components */
 	while (np && *path == '/') {
 		struct device_node *tmp = np;
 
@@ -453,6 +693,10 @@ struct device_node *of_find_node_by_phandle(struct device_node *root,
 	if (!handle)
 		return NULL;
 
+#if CONFIG_IS_ENABLED(OF_LOOKUP_INDEX)
+	if (of_index && (root ? root : gd->of_root) == of_index->root)
+		return of_index_find_phandle(of_index, handle);
+#endif
 	for_each_of_allnodes_from(root, np)
 		if (np->phandle == handle)
 			break;
@@ -1024,6 +1268,7 @@ int of_add_subnode(struct device_node *parent, const char *name, int len,
 	if (!parent->child)
 		parent->child = new;
 	new->parent = parent;
+	of_index_add_node(new);
 
 	*childp = new;
 
@@ -200,6 +200,225 @@ static ofnode ofnode_from_tree_offset(oftree tree, int offset)
 	return node;
 }
 
+#if CONFIG_IS_ENABLED(OFNODE_PROP_CACHE)
+#define PROP_CACHE_SIZE		CONFIG_OFNODE_PROP_CACHE_SIZE
+
+/**
+ * struct ofnode_prop_cache - offsets of recently read properties
+ *
+ * This remembers where properties of the control FDT were found, so that
+ * reading them again does not need to compare the name of every property
+ * in the node. Each property can only go in one slot, chosen by hashing the
+ * node offset and the property name, so a new entry simply replaces an old
+ * one.
+ *
+ * The cache is emptied when the size of the structure block changes, since
+ * that moves the properties around, and by writes through the ofnode
+ * interface. Since libfdt can also be used directly, each hit is checked
+ * too: the cached offset must be one of the node's properties, found by
+ * stepping over the properties before it without comparing names, and the
+ * property there must have the requested name.
+ *
+ * @blob: FDT which the cache refers to
+ * @struct_size: Size of the structure block of @blob when it was cached
+ * @slot: Cached properties, with @prop set to 0 if the slot is empty
+ * @slot.node: Node offset
+ * @slot.hash: Hash of the property name
+ * @slot.prop: Property offset
+ * @lookups: Number of property lookups (DM_STATS)
+ * @hits: Number of lookups found in the cache (DM_STATS)
+ * @untracked: Number of lookups on nodes with no room in @count (DM_STATS)
+ * @count: Lookups made on each node (DM_STATS)
+ */
+struct ofnode_prop_cache {
+	const void *blob;
+	int struct_size;
+	struct {
+		int node;
+		u32 hash;
+		int prop;
+	} slot[PROP_CACHE_SIZE];
+#if CONFIG_IS_ENABLED(DM_STATS)
+	uint lookups;
+	uint hits;
+	uint untracked;
+	struct ofnode_prop_count count[PROP_CACHE_SIZE];
+#endif
+};
+
+static u32 ofnode_prop_hash(const char *name)
+{
+	u32 hash = 2166136261U;
+
+	while (*name)
+		hash = (hash ^ (u8)*name++) * 16777619;
+
+	return hash;
+}
+
+static struct ofnode_prop_cache *ofnode_prop_cache_get(const void *fdt)
+{
+	struct ofnode_prop_cache *cache = gd->ofnode_prop_cache;
+	int struct_size = fdt_size_dt_struct(fdt);
+
+	if (!cache) {
+		if (fdt_version(fdt) < 17)
+			return NULL;
+		cache = calloc(1, sizeof(*cache));
+		if (!cache)
+			return NULL;
+		gd->ofnode_prop_cache = cache;
+	}
+	if (cache->blob != fdt || cache->struct_size != struct_size) {
+		memset(cache->slot, '\0', sizeof(cache->slot));
+#if CONFIG_IS_ENABLED(DM_STATS)
+		/* node offsets are only stale if the structure changed */
+		if (cache->struct_size != struct_size) {
+			memset(cache->count, '\0', sizeof(cache->count));
+			cache->untracked = 0;
+		}
+#endif
+		cache->blob = fdt;
+		cache->struct_size = struct_size;
+	}
+
+	return cache;
+}
+
+static void ofnode_prop_cache_count(struct ofnode_prop_cache *cache,
+				    int node, bool hit)
+{
+#if CONFIG_IS_ENABLED(DM_STATS)
+	struct ofnode_prop_count *count;
+	uint i, n;
+
+	cache->lookups++;
+	cache->hits += hit;
+	i = (node * 0x9e3779b1) & (PROP_CACHE_SIZE - 1);
+	for (n = 0; n < PROP_CACHE_SIZE; n++) {
+		count = &cache->count[i];
+		if (!count->lookups)
+			count->node = node;
+		if (count->node == node) {
+			count->lookups++;
+			count->hits += hit;
+			return;
+		}
+		i = (i + 1) & (PROP_CACHE_SIZE - 1);
+	}
+	cache->untracked++;
+#endif
+}
+
+static void ofnode_prop_cache_flush(const void *fdt)
+{
+	struct ofnode_prop_cache *cache = gd->ofnode_prop_cache;
+
+	if (cache && fdt == cache->blob)
+		memset(cache->slot, '\0', sizeof(cache->slot));
+}
+
+#if CONFIG_IS_ENABLED(DM_STATS)
+int ofnode_get_prop_stats(struct ofnode_prop_stats *stats)
+{
+	struct ofnode_prop_cache *cache = gd->ofnode_prop_cache;
+
+	if (!cache)
+		return -ENOENT;
+	stats->lookups = cache->lookups;
+	stats->hits = cache->hits;
+	stats->untracked = cache->untracked;
+	stats->count = cache->count;
+	stats->num_counts = PROP_CACHE_SIZE;
+
+	return 0;
+}
+#endif
+
+/*
+ * Check that the property at @prop belongs to @node. An edit which keeps the
+ * size of the structure block, such as deleting one property and adding
+ * another, can leave a cached offset pointing into a different node.
+ */
+static bool ofnode_prop_in_node(const void *fdt, int node, int prop)
+{
+	int offset;
+
+	fdt_for_each_property_offset(offset, fdt, node) {
+		if (offset >= prop)
+			return offset == prop;
+	}
+
+	return false;
+}
+
+static const void *ofnode_prop_cache_read(const void *fdt, int node,
+					  const char *propname, int *lenp)
+{
+	struct ofnode_prop_cache *cache;
+	const struct fdt_property *prop;
+	const char *name;
+	u32 hash;
+	uint i;
+
+	cache = ofnode_prop_cache_get(fdt);
+	if (!cache)
+		return fdt_getprop(fdt, node, propname, lenp);
+
+	hash = ofnode_prop_hash(propname);
+	i = (hash ^ (node * 0x9e3779b1)) & (PROP_CACHE_SIZE - 1);
+	if (cache->slot[i].prop && cache->slot[i].node == node &&
+	    cache->slot[i].hash == hash &&
+	    ofnode_prop_in_node(fdt, node, cache->slot[i].prop)) {
+		prop = fdt_get_property_by_offset(fdt, cache->slot[i].prop,
+						  lenp);
+		name = prop ? fdt_string(fdt, fdt32_to_cpu(prop->nameoff)) :
+			NULL;
+		if (name && !strcmp(name, propname)) {
+			ofnode_prop_cache_count(cache, node, true);
+			return prop->data;
+		}
+	}
+
+	ofnode_prop_cache_count(cache, node, false);
+	prop = fdt_get_property(fdt, node, propname, lenp);
+	if (!prop)
+		return NULL;
+	cache->slot[i].node = node;
+	cache->slot[i].hash = hash;
+	cache->slot[i].prop = (const char *)prop - (const char *)fdt -
+		fdt_off_dt_struct(fdt);
+
+	return prop->data;
+}
+#else
+static inline void ofnode_prop_cache_flush(const void *fdt) {}
+#endif /* OFNODE_PROP_CACHE */
+
+/**
+ * ofnode_fdt_getprop() - read a property from a flat-tree node
+ *
+ * This uses the property cache when reading from the control FDT.
+ *
+ * @node: node to read (must not be a live-tree node)
+ * @propname: name of the property to read
+ * @lenp: returns the length of the property value, or an -FDT_ERR_... error
+ * Return: property value, or NULL if not found
+ */
+static const void *ofnode_fdt_getprop(ofnode node, const char *propname,
+				      int *lenp)
+{
+	const void *fdt = ofnode_to_fdt(node);
+	int offset = ofnode_to_offset(node);
+
+#if CONFIG_IS_ENABLED(OFNODE_PROP_CACHE)
+	if (fdt == gd->fdt_blob && offset >= 0)
+		return ofnode_prop_cache_read(fdt, offset, propname, lenp);
+#endif
+
+	return fdt_getprop(fdt, offset, propname, lenp);
+}
+
 bool ofnode_name_eq(ofnode node, const char *name)
 {
 	const char *node_name;
@@ -224,8 +443,7 @@ int ofnode_read_u8(ofnode node, const char *propname, u8 *outp)
 	if (ofnode_is_np(node))
 		return of_read_u8(ofnode_to_np(node), propname, outp);
 
-	cell = fdt_getprop(gd->fdt_blob, ofnode_to_offset(node), propname,
-			   &len);
+	cell = ofnode_fdt_getprop(node, propname, &len);
 	if (!cell || len < sizeof(*cell)) {
 		debug("(not found)\n");
 		return -EINVAL;
@@ -255,8 +473,7 @@ int ofnode_read_u16(ofnode node, const char *propname, u16 *outp)
 	if (ofnode_is_np(node))
 		return of_read_u16(ofnode_to_np(node), propname, outp);
 
-	cell = fdt_getprop(gd->fdt_blob, ofnode_to_offset(node), propname,
-			   &len);
+	cell = ofnode_fdt_getprop(node, propname, &len);
 	if (!cell || len < sizeof(*cell)) {
 		debug("(not found)\n");
 		return -EINVAL;
@@ -301,8 +518,7 @@ int ofnode_read_u32_index(ofnode node, const char *propname, int index,
 		return of_read_u32_index(ofnode_to_np(node), propname, index,
 					 outp);
 
-	cell = fdt_getprop(ofnode_to_fdt(node), ofnode_to_offset(node),
-			   propname, &len);
+	cell = ofnode_fdt_getprop(node, propname, &len);
 	if (!cell) {
 		debug("(not found)\n");
 		return -EINVAL;
@@ -347,8 +563,7 @@ int ofnode_read_u64(ofnode node, const char *propname, u64 *outp)
 	if (ofnode_is_np(node))
 		return of_read_u64(ofnode_to_np(node), propname, outp);
 
-	cell = fdt_getprop(ofnode_to_fdt(node), ofnode_to_offset(node),
-			   propname, &len);
+	cell = ofnode_fdt_getprop(node, propname, &len);
 	if (!cell || len < sizeof(*cell)) {
 		debug("(not found)\n");
 		return -EINVAL;
@@ -399,8 +614,7 @@ const void *ofnode_read_prop(ofnode node, const char *propname, int *sizep)
 			len = prop->length;
 		}
 	} else {
-		val = fdt_getprop(ofnode_to_fdt(node), ofnode_to_offset(node),
-				  propname, &len);
+		val = ofnode_fdt_getprop(node, propname, &len);
 	}
 	if (!val) {
 		debug("<not found>\n");
@@ -586,8 +800,8 @@ ofnode ofnode_get_by_phandle(uint phandle)
 	if (of_live_active())
 		node = np_to_ofnode(of_find_node_by_phandle(NULL, phandle));
 	else
-		node.of_offset = fdt_node_offset_by_phandle(gd->fdt_blob,
-							    phandle);
+		node.of_offset = fdtdec_node_offset_by_phandle(gd->fdt_blob,
+							       phandle);
 
 	return node;
 }
@@ -600,8 +814,8 @@ ofnode oftree_get_by_phandle(oftree tree, uint phandle)
 		node = np_to_ofnode(of_find_node_by_phandle(tree.np, phandle));
 	else
 		node = ofnode_from_tree_offset(tree,
-			fdt_node_offset_by_phandle(oftree_lookup_fdt(tree),
-						   phandle));
+			fdtdec_node_offset_by_phandle(oftree_lookup_fdt(tree),
+						      phandle));
 
 	return node;
 }
@@ -1043,8 +1257,7 @@ const void *ofnode_get_property(ofnode node, const char *propname, int *lenp)
 	if (ofnode_is_np(node))
 		return of_get_property(ofnode_to_np(node), propname, lenp);
 	else
-		return fdt_getprop(ofnode_to_fdt(node), ofnode_to_offset(node),
-				   propname, lenp);
+		return ofnode_fdt_getprop(node, propname, lenp);
 }
 
 int ofnode_first_property(ofnode node, struct ofprop *prop)
@@ -1465,6 +1678,7 @@ int ofnode_write_prop(ofnode node, const char *propname, const void *value,
 			free(newval);
 		return ret;
 	} else {
+		ofnode_prop_cache_flush(ofnode_to_fdt(node));
 		return fdt_setprop(ofnode_to_fdt(node), ofnode_to_offset(node),
 				   propname, value, len);
 	}
@@ -1602,6 +1816,7 @@ int ofnode_add_subnode(ofnode node, const char *name, ofnode *subnodep)
 		int poffset = ofnode_to_offset(node);
 		int offset;
 
+		ofnode_prop_cache_flush(fdt);
 		offset = fdt_add_subnode(fdt, poffset, name);
 		if (offset == -FDT_ERR_EXISTS) {
 			offset = fdt_subnode_offset(fdt, poffset, name);
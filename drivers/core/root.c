@@ -9,6 +9,7 @@
 #define LOG_CATEGORY UCLASS_ROOT
 
 #include <common.h>
+#include <bootstage.h>
 #include <errno.h>
 #include <fdtdec.h>
 #include <log.h>
@@ -179,6 +180,9 @@ int dm_init(bool of_live)
 	} else {
 		gd->uclass_root = &DM_UCLASS_ROOT_S_NON_CONST;
 		INIT_LIST_HEAD(DM_UCLASS_ROOT_NON_CONST);
+		ret = dm_index_init();
+		if (ret)
+			return log_msg_ret("idx", ret);
 	}
 
 	if (IS_ENABLED(CONFIG_NEEDS_MANUAL_RELOC)) {
@@ -198,8 +202,9 @@ int dm_init(bool of_live)
 					  &DM_ROOT_NON_CONST);
 		if (ret)
 			return ret;
-		if (CONFIG_IS_ENABLED(OF_CONTROL))
-			dev_set_ofnode(DM_ROOT_NON_CONST, ofnode_root());
+		if (CONFIG_IS_ENABLED(OF_CONTROL)) {
+			device_set_ofnode(DM_ROOT_NON_CONST, ofnode_root());
+		}
 		ret = device_probe(DM_ROOT_NON_CONST);
 		if (ret)
 			return ret;
@@ -361,7 +366,19 @@ void *dm_priv_to_rw(void *priv)
 }
 #endif
 
-static int dm_probe_devices(struct udevice *dev, bool pre_reloc_only)
+/**
+ * dm_probe_devices() - Probe devices marked for probing after bind
+ *
+ * @dev: Device to start from; its children are probed too
+ * @pre_reloc_only: If true, only probe devices which are used before relocation
+ * @retry: Only probe devices which deferred their probe, and the devices below
+ *	them
+ * @probed: Incremented for each deferred device which now probed successfully
+ * @deferred: Incremented for each device which (still) defers its probe
+ * Return: 0 if OK, -ve error code from probing @dev
+ */
+static int dm_probe_devices(struct udevice *dev, bool pre_reloc_only,
+			    bool retry, int *probed, int *deferred)
 {
 	ofnode node = dev_ofnode(dev);
 	struct udevice *child;
@@ -372,15 +389,58 @@ static int dm_probe_devices(struct udevice *dev, bool pre_reloc_only)
 	    !(dev->driver->flags & DM_FLAG_PRE_RELOC))
 		goto probe_children;
 
+	if (retry && !(dev_get_flags(dev) & DM_FLAG_PROBE_DEFERRED))
+		goto probe_children;
+
 	if (dev_get_flags(dev) & DM_FLAG_PROBE_AFTER_BIND) {
-		ret = device_probe(dev);
+		ret = device_probe_start(dev);
+		if (ret == -EPROBE_DEFER && CONFIG_IS_ENABLED(DM_PROBE_DEFER)) {
+			/* The children need this device, so they wait too */
+			dev_or_flags(dev, DM_FLAG_PROBE_DEFERRED);
+			(*deferred)++;
+			return 0;
+		}
+		if (retry) {
+			dev_bic_flags(dev, DM_FLAG_PROBE_DEFERRED);
+			if (!ret)
+				(*probed)++;
+			retry = false;
+		}
 		if (ret)
 			return ret;
 	}
 
 probe_children:
 	list_for_each_entry(child, &dev->child_head, sibling_node)
-		dm_probe_devices(child, pre_reloc_only);
+		dm_probe_devices(child, pre_reloc_only, retry, probed,
+				 deferred);
+
+	return 0;
+}
+
+int dm_autoprobe(bool pre_reloc_only)
+{
+	int probed, deferred, pass;
+	int ret;
+
+	for (pass = 0;; pass++) {
+		probed = 0;
+		deferred = 0;
+		ret = dm_probe_devices(gd->dm_root, pre_reloc_only, pass > 0,
+				       &probed, &deferred);
+		device_probe_wait_all();
+		if (ret)
+			return ret;
+
+		/*
+		 * What a device waits for may have been probed later in the
+		 * first pass. After that, keep going while retries succeed.
+		 */
+		if (!deferred || (pass && !probed))
+			break;
+	}
+	if (deferred)
+		log_debug("%d device(s) still defer their probe\n", deferred);
 
 	return 0;
 }
@@ -417,7 +477,7 @@ static int dm_scan(bool pre_reloc_only)
 	if (ret)
 		return ret;
 
-	return dm_probe_devices(gd->dm_root, pre_reloc_only);
+	return dm_autoprobe(pre_reloc_only);
 }
 
 int dm_init_and_scan(bool pre_reloc_only)
@@ -504,6 +564,45 @@ void dm_get_mem(struct dm_stats *stats)
 		stats->tag_size;
 }
 
+#if CONFIG_IS_ENABLED(DM_TIMING)
+/* Keep @slow sorted by probe time, slowest first, as each device is added */
+static void dm_timing_slowest(struct udevice *dev, struct udevice **slow,
+			      int count)
+{
+	struct udevice *child, *ins = dev;
+	int i;
+
+	if (dev->probe_start_us) {
+		for (i = 0; i < count && ins; i++) {
+			if (!slow[i] ||
+			    slow[i]->probe_self_us < ins->probe_self_us)
+				swap(slow[i], ins);
+		}
+	}
+	device_foreach_child(child, dev)
+		dm_timing_slowest(child, slow, count);
+}
+
+void dm_timing_bootstage(void)
+{
+	struct udevice *slow[CONFIG_DM_TIMING_BOOTSTAGE] = { };
+	const char *name;
+	int i;
+
+	if (!gd->dm_root)
+		return;
+	dm_timing_slowest(gd->dm_root, slow, ARRAY_SIZE(slow));
+	for (i = 0; i < ARRAY_SIZE(slow) && slow[i]; i++) {
+		/* bootstage keeps the name, which outlives an unbound device */
+		name = strdup(slow[i]->name);
+		if (!name)
+			break;
+		bootstage_add_accum(name, slow[i]->probe_start_us,
+				    slow[i]->probe_self_us);
+	}
+}
+#endif
+
 #ifdef CONFIG_ACPIGEN
 static int root_acpi_get_name(const struct udevice *dev, char *out_name)
 {
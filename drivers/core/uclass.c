@@ -23,17 +23,226 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+#define DM_INDEX_BITS		8
+#define DM_INDEX_BUCKETS	(1 << DM_INDEX_BITS)
+
+/**
+ * struct dm_index - lookup tables for uclasses and devices
+ *
+ * Devices are hashed together with their uclass ID, so a lookup only has to
+ * check the few devices sharing its bucket. Within a bucket devices are kept
+ * in bind order, the same order as the uclass device list, so the index finds
+ * the same device as a walk of the list would.
+ *
+ * @uclass: uclasses indexed by ID, NULL if not created yet
+ * @seq: devices hashed by sequence number
+ * @node: devices hashed by device tree node
+ * @phandle: devices hashed by the phandle of their node
+ */
+struct dm_index {
+	struct uclass *uclass[UCLASS_COUNT];
+	struct hlist_head seq[DM_INDEX_BUCKETS];
+	struct hlist_head node[DM_INDEX_BUCKETS];
+	struct hlist_head phandle[DM_INDEX_BUCKETS];
+};
+
+int dm_index_init(void)
+{
+	/* The index is allocated once and reused across dm_init() calls */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return 0;
+	if (gd->dm_index) {
+		memset(gd->dm_index, '\0', sizeof(struct dm_index));
+		return 0;
+	}
+	gd->dm_index = calloc(1, sizeof(struct dm_index));
+	if (!gd->dm_index)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static struct dm_index *dm_index(void)
+{
+	return gd->dm_index;
+}
+
+static struct hlist_head *dm_index_bucket(struct hlist_head *table,
+					  enum uclass_id id, ulong key)
+{
+	u32 hash = (u32)key ^ (u32)((u64)key >> 32);
+
+	hash = (hash + ((u32)id << 16)) * 0x9e3779b1;
+
+	return &table[hash >> (32 - DM_INDEX_BITS)];
+}
+
+static void dm_index_add_tail(struct hlist_node *n, struct hlist_head *head)
+{
+	struct hlist_node *last;
+
+	if (hlist_empty(head)) {
+		hlist_add_head(n, head);
+		return;
+	}
+	for (last = head->first; last->next; last = last->next)
+		;
+	hlist_add_after(last, n);
+}
+
+static void dm_index_add_dev(struct udevice *dev)
+{
+	struct dm_index *idx = dm_index();
+	enum uclass_id id = dev->uclass->uc_drv->id;
+	ofnode node = dev_ofnode(dev);
+	uint phandle;
+
+	if (!idx)
+		return;
+	if (dev->seq_ != -1)
+		dm_index_add_tail(&dev->seq_hnode,
+				  dm_index_bucket(idx->seq, id, dev->seq_));
+	if (!ofnode_valid(node))
+		return;
+	dm_index_add_tail(&dev->node_hnode,
+			  dm_index_bucket(idx->node, id, node.of_offset));
+	phandle = dev_read_phandle(dev);
+	if (phandle)
+		dm_index_add_tail(&dev->phandle_hnode,
+				  dm_index_bucket(idx->phandle, id, phandle));
+}
+
+static void dm_index_del_dev(struct udevice *dev)
+{
+	if (!hlist_unhashed(&dev->seq_hnode))
+		hlist_del_init(&dev->seq_hnode);
+	if (!hlist_unhashed(&dev->node_hnode))
+		hlist_del_init(&dev->node_hnode);
+	if (!hlist_unhashed(&dev->phandle_hnode))
+		hlist_del_init(&dev->phandle_hnode);
+}
+
+void uclass_reindex_device(struct udevice *dev)
+{
+	if (!dm_index())
+		return;
+	dm_index_del_dev(dev);
+	dm_index_add_dev(dev);
+}
+
+static void dm_index_set_uclass(enum uclass_id id, struct uclass *uc)
+{
+	if (dm_index())
+		dm_index()->uclass[id] = uc;
+}
+
+/*
+ * The dm_index_find_...() functions return -ENOSYS when there is no index,
+ * in which case the caller walks the uclass device list instead
+ */
+static int dm_index_find_uclass(enum uclass_id id, struct uclass **ucp)
+{
+	if (!dm_index())
+		return -ENOSYS;
+	*ucp = (uint)id < UCLASS_COUNT ? dm_index()->uclass[id] : NULL;
+
+	return 0;
+}
+
+static int dm_index_find_seq(struct uclass *uc, int seq, struct udevice **devp)
+{
+	struct udevice *dev;
+
+	if (!dm_index())
+		return -ENOSYS;
+	hlist_for_each_entry(dev, dm_index_bucket(dm_index()->seq,
+						  uc->uc_drv->id, seq),
+			     seq_hnode) {
+		if (dev->uclass == uc && dev->seq_ == seq) {
+			*devp = dev;
+			return 0;
+		}
+	}
+
+	return -ENODEV;
+}
+
+static int dm_index_find_node(struct uclass *uc, ofnode node,
+			      struct udevice **devp)
+{
+	struct udevice *dev;
+
+	if (!dm_index())
+		return -ENOSYS;
+	hlist_for_each_entry(dev, dm_index_bucket(dm_index()->node,
+						  uc->uc_drv->id,
+						  node.of_offset),
+			     node_hnode) {
+		if (dev->uclass == uc && ofnode_equal(dev_ofnode(dev), node)) {
+			*devp = dev;
+			return 0;
+		}
+	}
+
+	return -ENODEV;
+}
+
+static int dm_index_find_phandle(struct uclass *uc, uint phandle,
+				 struct udevice **devp)
+{
+	struct udevice *dev;
+
+	if (!dm_index())
+		return -ENOSYS;
+	hlist_for_each_entry(dev, dm_index_bucket(dm_index()->phandle,
+						  uc->uc_drv->id, phandle),
+			     phandle_hnode) {
+		if (dev->uclass == uc && dev_read_phandle(dev) == phandle) {
+			*devp = dev;
+			return 0;
+		}
+	}
+
+	return -ENODEV;
+}
+#else
+static void dm_index_add_dev(struct udevice *dev) {}
+static void dm_index_del_dev(struct udevice *dev) {}
+static void dm_index_set_uclass(enum uclass_id id, struct uclass *uc) {}
+
+static int dm_index_find_uclass(enum uclass_id id, struct uclass **ucp)
+{
+	return -ENOSYS;
+}
+
+static int dm_index_find_seq(struct uclass *uc, int seq, struct udevice **devp)
+{
+	return -ENOSYS;
+}
+
+static int dm_index_find_node(struct uclass *uc, ofnode node,
+			      struct udevice **devp)
+{
+	return -ENOSYS;
+}
+
+static int dm_index_find_phandle(struct uclass *uc, uint phandle,
+				 struct udevice **devp)
+{
+	return -ENOSYS;
+}
+#endif
+
 struct uclass *uclass_find(enum uclass_id key)
 {
 	struct uclass *uc;
 
 	if (!gd->dm_root)
 		return NULL;
-	/*
-	 * TODO(sjg@chromium.org): Optimise this, perhaps moving the found
-	 * node to the start of the list, or creating a linear array mapping
-	 * id to node.
-	 */
+	if (!dm_index_find_uclass(key, &uc))
+		return uc;
+
 	list_for_each_entry(uc, gd->uclass_root, sibling_node) {
 		if (uc->uc_drv->id == key)
 			return uc;
@@ -86,6 +295,7 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 	INIT_LIST_HEAD(&uc->sibling_node);
 	INIT_LIST_HEAD(&uc->dev_head);
 	list_add(&uc->sibling_node, DM_UCLASS_ROOT_NON_CONST);
+	dm_index_set_uclass(id, uc);
 
 	if (uc_drv->init) {
 		ret = uc_drv->init(uc);
@@ -101,6 +311,7 @@ fail:
 		free(uclass_get_priv(uc));
 		uclass_set_priv(uc, NULL);
 	}
+	dm_index_set_uclass(id, NULL);
 	list_del(&uc->sibling_node);
 fail_mem:
 	free(uc);
@@ -134,6 +345,7 @@ int uclass_destroy(struct uclass *uc)
 	uc_drv = uc->uc_drv;
 	if (uc_drv->destroy)
 		uc_drv->destroy(uc);
+	dm_index_set_uclass(uc_drv->id, NULL);
 	list_del(&uc->sibling_node);
 	if (uc_drv->priv_auto)
 		free(uclass_get_priv(uc));
@@ -342,6 +554,9 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq, struct udevice **devp)
 	if (ret)
 		return ret;
 
+	ret = dm_index_find_seq(uc, seq, devp);
+	if (ret != -ENOSYS)
+		return ret;
 	uclass_foreach_dev(dev, uc) {
 		log_debug("   - %d '%s'\n", dev->seq_, dev->name);
 		if (dev->seq_ == seq) {
@@ -394,6 +609,9 @@ int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 	if (ret)
 		return ret;
 
+	ret = dm_index_find_node(uc, node, devp);
+	if (ret != -ENOSYS)
+		goto done;
 	uclass_foreach_dev(dev, uc) {
 		log(LOGC_DM, LOGL_DEBUG_CONTENT, "      - checking %s\n",
 		    dev->name);
@@ -423,6 +641,9 @@ static int uclass_find_device_by_phandle_id(enum uclass_id id,
 	if (ret)
 		return ret;
 
+	ret = dm_index_find_phandle(uc, find_phandle, devp);
+	if (ret != -ENOSYS)
+		return ret;
 	uclass_foreach_dev(dev, uc) {
 		uint phandle;
 
@@ -694,6 +915,7 @@ int uclass_bind_device(struct udevice *dev)
 
 	uc = dev->uclass;
 	list_add_tail(&dev->uclass_node, &uc->dev_head);
+	dm_index_add_dev(dev);
 
 	if (dev->parent) {
 		struct uclass_driver *uc_drv = dev->parent->uclass->uc_drv;
@@ -708,6 +930,7 @@ int uclass_bind_device(struct udevice *dev)
 	return 0;
 err:
 	/* There is no need to undo the parent's post_bind call */
+	dm_index_del_dev(dev);
 	list_del(&dev->uclass_node);
 
 	return ret;
@@ -731,6 +954,7 @@ int uclass_pre_unbind_device(struct udevice *dev)
 
 int uclass_unbind_device(struct udevice *dev)
 {
+	dm_index_del_dev(dev);
 	list_del(&dev->uclass_node);
 
 	return 0;
@@ -805,8 +1029,17 @@ int uclass_pre_remove_device(struct udevice *dev)
 int uclass_probe_all(enum uclass_id id)
 {
 	struct udevice *dev;
+	struct uclass *uc;
 	int ret, err;
 
+	/* Get devices which probe asynchronously settling at the same time */
+	if (CONFIG_IS_ENABLED(DM_ASYNC_PROBE)) {
+		uclass_id_foreach_dev(id, dev, uc) {
+			if (dev->driver->flags & DM_FLAG_ASYNC_PROBE)
+				device_probe_start(dev);
+		}
+	}
+
 	err = uclass_first_device_check(id, &dev);
 
 	/* Scanning uclass to probe all devices */
@@ -74,8 +74,10 @@ int sandbox_eth_arp_req_to_reply(struct udevice *dev, void *packet,
 		return -EAGAIN;
 
 	/* Don't allow the buffer to overrun */
-	if (priv->recv_packets >= PKTBUFSRX)
+	if (priv->recv_packets >= PKTBUFSRX) {
+		eth_count_rx_drop(dev, 0, 1);
 		return 0;
+	}
 
 	/* store this as the assumed IP of the fake host */
 	priv->fake_host_ipaddr = net_read_ip(&arp->ar_tpa);
@@ -136,8 +138,10 @@ int sandbox_eth_ping_req_to_reply(struct udevice *dev, void *packet,
 		return -EAGAIN;
 
 	/* Don't allow the buffer to overrun */
-	if (priv->recv_packets >= PKTBUFSRX)
+	if (priv->recv_packets >= PKTBUFSRX) {
+		eth_count_rx_drop(dev, 0, 1);
 		return 0;
+	}
 
 	/* reply to the ping */
 	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
@@ -176,8 +180,10 @@ int sandbox_eth_recv_arp_req(struct udevice *dev)
 	struct arp_hdr *arp_recv;
 
 	/* Don't allow the buffer to overrun */
-	if (priv->recv_packets >= PKTBUFSRX)
+	if (priv->recv_packets >= PKTBUFSRX) {
+		eth_count_rx_drop(dev, 0, 1);
 		return -EOVERFLOW;
+	}
 
 	/* Formulate a fake request */
 	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
@@ -218,8 +224,10 @@ int sandbox_eth_recv_ping_req(struct udevice *dev)
 	struct icmp_hdr *icmpr;
 
 	/* Don't allow the buffer to overrun */
-	if (priv->recv_packets >= PKTBUFSRX)
+	if (priv->recv_packets >= PKTBUFSRX) {
+		eth_count_rx_drop(dev, 0, 1);
 		return -EOVERFLOW;
+	}
 
 	/* Formulate a fake ping */
 	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
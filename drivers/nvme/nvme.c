@@ -22,12 +22,31 @@
 #define NVME_AQ_DEPTH		2
 #define NVME_SQ_SIZE(depth)	(depth * sizeof(struct nvme_command))
 #define NVME_CQ_SIZE(depth)	(depth * sizeof(struct nvme_completion))
-#define NVME_CQ_ALLOCATION	ALIGN(NVME_CQ_SIZE(NVME_Q_DEPTH), \
-				      ARCH_DMA_MINALIGN)
+#define NVME_CQ_ALLOCATION(depth)	ALIGN(NVME_CQ_SIZE(depth), \
+					      ARCH_DMA_MINALIGN)
 #define ADMIN_TIMEOUT		60
 #define IO_TIMEOUT		30
 #define MAX_PRP_POOL		512
 
+/*
+ * struct nvme_io - progress of a transfer split into several I/O commands
+ *
+ * @req:	Block request being carried out, or NULL for a synchronous
+ *		transfer
+ * @pending:	Number of commands still in flight
+ * @blkcnt:	Total number of blocks in the transfer
+ * @err_blk:	First block of the earliest failed command, or @blkcnt if none
+ *		failed
+ * @status:	0 if OK, else the error of the first failed command
+ */
+struct nvme_io {
+	struct blk_request *req;
+	uint pending;
+	u64 blkcnt;
+	u64 err_blk;
+	int status;
+};
+
 static int nvme_wait_csts(struct nvme_dev *dev, u32 mask, u32 val)
 {
 	int timeout;
@@ -45,8 +64,19 @@ static int nvme_wait_csts(struct nvme_dev *dev, u32 mask, u32 val)
 	return -ETIME;
 }
 
-static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
-			   int total_len, u64 dma_addr)
+/**
+ * nvme_setup_prps() - set up the PRP entries for a transfer
+ *
+ * @dev:	NVMe device
+ * @poolp:	PRP list to use, reallocated if it is too small
+ * @entry_nump:	Number of entries which fit in *@poolp, updated if reallocated
+ * @prp2:	Returns the value for the PRP2 field of the command
+ * @total_len:	Length of the transfer in bytes
+ * @dma_addr:	Start of the transfer, used for PRP1
+ * Return: 0 if OK, -ENOMEM if the PRP list could not be allocated
+ */
+static int nvme_setup_prps(struct nvme_dev *dev, u64 **poolp, u32 *entry_nump,
+			   u64 *prp2, int total_len, u64 dma_addr)
 {
 	u32 page_size = dev->page_size;
 	int offset = dma_addr & (page_size - 1);
@@ -74,41 +104,53 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	nprps = DIV_ROUND_UP(length, page_size);
 	num_pages = DIV_ROUND_UP(nprps - 1, prps_per_page - 1);
 
-	if (nprps > dev->prp_entry_num) {
-		free(dev->prp_pool);
+	if (nprps > *entry_nump) {
+		free(*poolp);
 		/*
 		 * Always increase in increments of pages.  It doesn't waste
 		 * much memory and reduces the number of allocations.
 		 */
-		dev->prp_pool = memalign(page_size, num_pages * page_size);
-		if (!dev->prp_pool) {
+		*poolp = memalign(page_size, num_pages * page_size);
+		if (!*poolp) {
 			printf("Error: malloc prp_pool fail\n");
+			*entry_nump = 0;
 			return -ENOMEM;
 		}
-		dev->prp_entry_num = num_pages * (prps_per_page - 1) + 1;
+		*entry_nump = num_pages * (prps_per_page - 1) + 1;
 	}
 
-	prp_pool = dev->prp_pool;
+	prp_pool = *poolp;
 	i = 0;
 	while (nprps) {
 		if ((i == (prps_per_page - 1)) && nprps > 1) {
 			*(prp_pool + i) = cpu_to_le64((ulong)prp_pool +
 					page_size);
 			i = 0;
-			prp_pool += page_size;
+			prp_pool += prps_per_page;
 		}
 		*(prp_pool + i++) = cpu_to_le64(dma_addr);
 		dma_addr += page_size;
 		nprps--;
 	}
-	*prp2 = (ulong)dev->prp_pool;
+	*prp2 = (ulong)*poolp;
 
-	flush_dcache_range((ulong)dev->prp_pool, (ulong)dev->prp_pool +
+	flush_dcache_range((ulong)*poolp, (ulong)*poolp +
 			   num_pages * page_size);
 
 	return 0;
 }
 
+/*
+ * Controllers with their own command submission handle one command at a time,
+ * so only standard controllers can have several I/O commands in flight
+ */
+static bool nvme_queued_io(struct nvme_dev *dev)
+{
+	struct nvme_ops *ops = (struct nvme_ops *)dev->udev->driver->ops;
+
+	return !ops || !ops->submit_cmd;
+}
+
 static __le16 nvme_get_cmd_id(void)
 {
 	static unsigned short cmdid;
@@ -125,7 +167,7 @@ static u16 nvme_read_completion_status(struct nvme_queue *nvmeq, u16 index)
 	 * as the cache line should never become dirty.
 	 */
 	ulong start = (ulong)&nvmeq->cqes[0];
-	ulong stop = start + NVME_CQ_ALLOCATION;
+	ulong stop = start + NVME_CQ_ALLOCATION(nvmeq->q_depth);
 
 	invalidate_dcache_range(start, stop);
 
@@ -234,7 +276,7 @@ static struct nvme_queue *nvme_alloc_queue(struct nvme_dev *dev,
 		return NULL;
 	memset(nvmeq, 0, sizeof(*nvmeq));
 
-	nvmeq->cqes = (void *)memalign(4096, NVME_CQ_ALLOCATION);
+	nvmeq->cqes = (void *)memalign(4096, NVME_CQ_ALLOCATION(depth));
 	if (!nvmeq->cqes)
 		goto free_nvmeq;
 	memset((void *)nvmeq->cqes, 0, NVME_CQ_SIZE(depth));
@@ -244,6 +286,12 @@ static struct nvme_queue *nvme_alloc_queue(struct nvme_dev *dev,
 		goto free_queue;
 	memset((void *)nvmeq->sq_cmds, 0, NVME_SQ_SIZE(depth));
 
+	if (qid != NVME_ADMIN_Q) {
+		nvmeq->slots = calloc(depth, sizeof(*nvmeq->slots));
+		if (!nvmeq->slots)
+			goto free_cmds;
+	}
+
 	nvmeq->dev = dev;
 
 	nvmeq->cq_head = 0;
@@ -260,6 +308,8 @@ static struct nvme_queue *nvme_alloc_queue(struct nvme_dev *dev,
 
 	return nvmeq;
 
+ free_cmds:
+	free(nvmeq->sq_cmds);
  free_queue:
 	free((void *)nvmeq->cqes);
  free_nvmeq:
@@ -318,6 +368,11 @@ static int nvme_shutdown_ctrl(struct nvme_dev *dev)
 
 static void nvme_free_queue(struct nvme_queue *nvmeq)
 {
+	int i;
+
+	for (i = 0; nvmeq->slots && i < nvmeq->q_depth; i++)
+		free(nvmeq->slots[i].prp_pool);
+	free(nvmeq->slots);
 	free((void *)nvmeq->cqes);
 	free(nvmeq->sq_cmds);
 	free(nvmeq);
@@ -338,14 +393,23 @@ static void nvme_free_queues(struct nvme_dev *dev, int lowest)
 static void nvme_init_queue(struct nvme_queue *nvmeq, u16 qid)
 {
 	struct nvme_dev *dev = nvmeq->dev;
+	int i;
 
 	nvmeq->sq_tail = 0;
 	nvmeq->cq_head = 0;
 	nvmeq->cq_phase = 1;
+	nvmeq->inflight = 0;
+	if (nvmeq->slots) {
+		for (i = 0; i < nvmeq->q_depth; i++) {
+			nvmeq->slots[i].io = NULL;
+			nvmeq->slots[i].cancelled = false;
+		}
+	}
 	nvmeq->q_db = &dev->dbs[qid * 2 * dev->db_stride];
 	memset((void *)nvmeq->cqes, 0, NVME_CQ_SIZE(nvmeq->q_depth));
 	flush_dcache_range((ulong)nvmeq->cqes,
-			   (ulong)nvmeq->cqes + NVME_CQ_ALLOCATION);
+			   (ulong)nvmeq->cqes +
+			   NVME_CQ_ALLOCATION(nvmeq->q_depth));
 	dev->online_queues++;
 }
 
@@ -596,12 +660,14 @@ static int nvme_setup_io_queues(struct nvme_dev *dev)
 	int nr_io_queues;
 	int result;
 
-	nr_io_queues = 1;
+	nr_io_queues = nvme_queued_io(dev) ? CONFIG_NVME_IO_QUEUES : 1;
 	result = nvme_set_queue_count(dev, nr_io_queues);
 	if (result <= 0)
 		return result;
+	nr_io_queues = min(nr_io_queues, result);
 
 	dev->max_qid = nr_io_queues;
+	dev->next_io_qid = NVME_IO_Q;
 
 	/* Free previously allocated queues */
 	nvme_free_queues(dev, nr_io_queues + 1);
@@ -728,8 +794,340 @@ static int nvme_blk_probe(struct udevice *udev)
 	return 0;
 }
 
-static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
-			 lbaint_t blkcnt, void *buffer, bool read)
+/* Maximum number of blocks in one I/O command, limited by its length field */
+static u32 nvme_max_lbas(struct nvme_dev *dev, struct nvme_ns *ns)
+{
+	return min(1U << (dev->max_transfer_shift - ns->lba_shift), 0x10000U);
+}
+
+/**
+ * nvme_queue_rw() - queue a read or write command on an I/O queue
+ *
+ * @nvmeq:	Queue to use, which must have a free slot
+ * @ns:		Namespace to access
+ * @io:		Transfer which the command is part of
+ * @offset:	First block of the command, relative to the transfer
+ * @slba:	First block of the command on the device
+ * @lbas:	Number of blocks
+ * @buf:	Memory to transfer, already flushed from the cache
+ * @read:	true to read, false to write
+ * Return: 0 if OK, -ve on error
+ */
+static int nvme_queue_rw(struct nvme_queue *nvmeq, struct nvme_ns *ns,
+			 struct nvme_io *io, u64 offset, u64 slba, u32 lbas,
+			 void *buf, bool read)
+{
+	struct nvme_cmd_slot *slot;
+	struct nvme_command c;
+	u64 prp2;
+	u16 id;
+	int ret;
+
+	for (id = 0; nvmeq->slots[id].io || nvmeq->slots[id].cancelled; id++)
+		;
+	slot = &nvmeq->slots[id];
+	ret = nvme_setup_prps(nvmeq->dev, &slot->prp_pool,
+			      &slot->prp_entry_num, &prp2,
+			      lbas << ns->lba_shift, (ulong)buf);
+	if (ret)
+		return ret;
+
+	memset(&c, 0, sizeof(c));
+	c.rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
+	c.rw.command_id = cpu_to_le16(id);
+	c.rw.nsid = cpu_to_le32(ns->ns_id);
+	c.rw.slba = cpu_to_le64(slba);
+	c.rw.length = cpu_to_le16(lbas - 1);
+	c.rw.prp1 = cpu_to_le64((ulong)buf);
+	c.rw.prp2 = cpu_to_le64(prp2);
+
+	slot->io = io;
+	slot->offset = offset;
+	slot->len = lbas << ns->lba_shift;
+	slot->buf = buf;
+	slot->read = read;
+	nvmeq->inflight++;
+	io->pending++;
+	nvme_submit_cmd(nvmeq, &c);
+
+	return 0;
+}
+
+/* Record that a command has finished, completing its request if needed */
+static void nvme_cmd_done(struct nvme_queue *nvmeq, struct nvme_cmd_slot *slot,
+			  int status, int *reqs_done)
+{
+	struct nvme_io *io = slot->io;
+
+	if (status) {
+		if (!io->status)
+			io->status = status;
+		io->err_blk = min(io->err_blk, slot->offset);
+	} else if (slot->read) {
+		invalidate_dcache_range((ulong)slot->buf,
+					(ulong)slot->buf + slot->len);
+	}
+	slot->io = NULL;
+	nvmeq->inflight--;
+
+	if (!--io->pending && io->req) {
+		blk_request_done(io->req, io->status ? io->err_blk : io->blkcnt,
+				 io->status);
+		free(io);
+		if (reqs_done)
+			(*reqs_done)++;
+	}
+}
+
+/**
+ * nvme_reap() - process the completed commands on an I/O queue
+ *
+ * @nvmeq:	Queue to check
+ * @reqs_done:	Incremented for each block request which completes, or NULL
+ * Return: number of commands which completed
+ */
+static int nvme_reap(struct nvme_queue *nvmeq, int *reqs_done)
+{
+	u16 head = nvmeq->cq_head;
+	u16 phase = nvmeq->cq_phase;
+	int count = 0;
+	u16 status, id;
+
+	for (;;) {
+		status = nvme_read_completion_status(nvmeq, head);
+		if ((status & 0x01) != phase)
+			break;
+
+		id = readw(&nvmeq->cqes[head].command_id);
+		nvmeq->sq_head = readw(&nvmeq->cqes[head].sq_head);
+		if (++head == nvmeq->q_depth) {
+			head = 0;
+			phase = !phase;
+		}
+
+		status >>= 1;
+		if (status)
+			printf("ERROR: status = %x, command = %d, queue = %d\n",
+			       status, id, nvmeq->qid);
+
+		if (id < nvmeq->q_depth && nvmeq->slots[id].cancelled) {
+			/* a command which was given up on, so its ID is free */
+			nvmeq->slots[id].cancelled = false;
+			nvmeq->inflight--;
+		} else if (id < nvmeq->q_depth && nvmeq->slots[id].io) {
+			nvme_cmd_done(nvmeq, &nvmeq->slots[id],
+				      status ? -EIO : 0, reqs_done);
+		}
+		count++;
+	}
+
+	if (count) {
+		writel(head, nvmeq->q_db + nvmeq->dev->db_stride);
+		nvmeq->cq_head = head;
+		nvmeq->cq_phase = phase;
+	}
+
+	return count;
+}
+
+/* Get the next I/O queue with a free slot, in turn, or NULL if all are full */
+static struct nvme_queue *nvme_pick_queue(struct nvme_dev *dev)
+{
+	struct nvme_queue *nvmeq;
+	unsigned int i, qid;
+
+	for (i = NVME_IO_Q; i < dev->online_queues; i++) {
+		qid = dev->next_io_qid;
+		if (++dev->next_io_qid >= dev->online_queues)
+			dev->next_io_qid = NVME_IO_Q;
+
+		nvmeq = dev->queues[qid];
+		if (nvmeq->inflight < nvmeq->q_depth - 1)
+			return nvmeq;
+	}
+
+	return NULL;
+}
+
+/* Wait until at least one command completes on any I/O queue */
+static int nvme_wait_io(struct nvme_dev *dev)
+{
+	ulong start = get_timer(0);
+	unsigned int qid;
+
+	do {
+		for (qid = NVME_IO_Q; qid < dev->online_queues; qid++)
+			if (nvme_reap(dev->queues[qid], NULL))
+				return 0;
+	} while (get_timer(start) < IO_TIMEOUT * 1000);
+
+	return -ETIMEDOUT;
+}
+
+/*
+ * Give up on the commands of a transfer which are still in flight. The
+ * controller may yet complete them, so their slots stay in use until it does,
+ * or else a late completion could be taken for a new command with the same ID.
+ */
+static void nvme_cancel_io(struct nvme_dev *dev, struct nvme_io *io)
+{
+	struct nvme_queue *nvmeq;
+	unsigned int qid;
+	int i;
+
+	for (qid = NVME_IO_Q; qid < dev->online_queues; qid++) {
+		nvmeq = dev->queues[qid];
+		for (i = 0; i < nvmeq->q_depth; i++) {
+			if (nvmeq->slots[i].io != io)
+				continue;
+			io->err_blk = min(io->err_blk, nvmeq->slots[i].offset);
+			nvmeq->slots[i].io = NULL;
+			nvmeq->slots[i].cancelled = true;
+			io->pending--;
+		}
+	}
+}
+
+/*
+ * Carry out a transfer with as many commands in flight as the I/O queues
+ * allow, each as large as the controller accepts
+ */
+static ulong nvme_blk_rw_queued(struct udevice *udev, lbaint_t blknr,
+				lbaint_t blkcnt, void *buffer, bool read)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+	struct nvme_dev *dev = ns->dev;
+	struct blk_desc *desc = dev_get_uclass_plat(udev);
+	struct nvme_io io = { .blkcnt = blkcnt, .err_blk = blkcnt };
+	struct nvme_queue *nvmeq;
+	u64 offset = 0;
+	u32 lbas;
+	int ret;
+
+	flush_dcache_range((unsigned long)buffer,
+			   (unsigned long)buffer + (blkcnt << desc->log2blksz));
+
+	while (offset < blkcnt && !io.status) {
+		nvmeq = nvme_pick_queue(dev);
+		if (!nvmeq) {
+			ret = nvme_wait_io(dev);
+			if (ret)
+				break;
+			continue;
+		}
+
+		lbas = min_t(u64, blkcnt - offset, nvme_max_lbas(dev, ns));
+		ret = nvme_queue_rw(nvmeq, ns, &io, offset, blknr + offset,
+				    lbas, buffer + (offset << ns->lba_shift),
+				    read);
+		if (ret)
+			break;
+		offset += lbas;
+	}
+	if (offset < blkcnt)
+		io.err_blk = min(io.err_blk, offset);
+
+	while (io.pending) {
+		if (nvme_wait_io(dev)) {
+			printf("Error: %s: I/O timed out\n", udev->name);
+			nvme_cancel_io(dev, &io);
+		}
+	}
+
+	return io.err_blk;
+}
+
+static int nvme_blk_submit(struct udevice *udev, struct blk_request *req)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+	struct nvme_dev *dev = ns->dev;
+	struct blk_desc *desc = dev_get_uclass_plat(udev);
+	struct nvme_queue *nvmeq = NULL;
+	u32 max_lbas = nvme_max_lbas(dev, ns);
+	uint needed = 0, qid, i;
+	struct nvme_io *io;
+	u64 offset = 0;
+	int ret = 0;
+
+	if (!nvme_queued_io(dev))
+		return -ENOSYS;
+
+	if (!blk_request_blkcnt(req)) {
+		blk_request_done(req, 0, 0);
+		return 0;
+	}
+
+	/* use the emptiest queue, if it has room for the whole request */
+	for (i = 0; i < req->sg_count; i++)
+		needed += DIV_ROUND_UP(req->sg[i].blkcnt, max_lbas);
+	for (qid = NVME_IO_Q; qid < dev->online_queues; qid++) {
+		if (!nvmeq || dev->queues[qid]->inflight < nvmeq->inflight)
+			nvmeq = dev->queues[qid];
+	}
+	if (!nvmeq || needed > nvmeq->q_depth - 1)
+		return -ENOSYS;
+	if (needed > nvmeq->q_depth - 1 - nvmeq->inflight)
+		return -EBUSY;
+
+	io = calloc(1, sizeof(*io));
+	if (!io)
+		return -ENOMEM;
+	io->req = req;
+	io->blkcnt = blk_request_blkcnt(req);
+	io->err_blk = io->blkcnt;
+	req->drv_priv = io;
+
+	for (i = 0; i < req->sg_count && !ret; i++) {
+		struct blk_sg *sg = &req->sg[i];
+		lbaint_t done = 0;
+		u32 lbas;
+
+		flush_dcache_range((ulong)sg->buf, (ulong)sg->buf +
+				   (sg->blkcnt << desc->log2blksz));
+		while (done < sg->blkcnt) {
+			lbas = min_t(u64, sg->blkcnt - done, max_lbas);
+			ret = nvme_queue_rw(nvmeq, ns, io, offset,
+					    req->start + offset, lbas,
+					    sg->buf + (done << ns->lba_shift),
+					    req->op == BLK_REQ_READ);
+			if (ret)
+				break;
+			done += lbas;
+			offset += lbas;
+		}
+	}
+
+	if (ret) {
+		io->status = ret;
+		io->err_blk = offset;
+		if (!io->pending) {
+			blk_request_done(req, offset, ret);
+			free(io);
+		}
+	}
+
+	return 0;
+}
+
+static int nvme_blk_poll(struct udevice *udev)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+	struct nvme_dev *dev = ns->dev;
+	int reqs_done = 0;
+	unsigned int qid;
+
+	if (!nvme_queued_io(dev))
+		return 0;
+
+	for (qid = NVME_IO_Q; qid < dev->online_queues; qid++)
+		nvme_reap(dev->queues[qid], &reqs_done);
+
+	return reqs_done;
+}
+
+/* Carry out a transfer one command at a time */
+static ulong nvme_blk_rw_sync(struct udevice *udev, lbaint_t blknr,
+			      lbaint_t blkcnt, void *buffer, bool read)
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
 	struct nvme_dev *dev = ns->dev;
@@ -766,8 +1164,8 @@ static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 			total_lbas -= lbas;
 		}
 
-		if (nvme_setup_prps(dev, &prp2,
-				    lbas << ns->lba_shift, temp_buffer))
+		if (nvme_setup_prps(dev, &dev->prp_pool, &dev->prp_entry_num,
+				    &prp2, lbas << ns->lba_shift, temp_buffer))
 			return -EIO;
 		c.rw.slba = cpu_to_le64(slba);
 		slba += lbas;
@@ -789,6 +1187,17 @@ static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 	return (total_len - temp_len) >> desc->log2blksz;
 }
 
+static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
+			 lbaint_t blkcnt, void *buffer, bool read)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+
+	if (nvme_queued_io(ns->dev))
+		return nvme_blk_rw_queued(udev, blknr, blkcnt, buffer, read);
+
+	return nvme_blk_rw_sync(udev, blknr, blkcnt, buffer, read);
+}
+
 static ulong nvme_blk_read(struct udevice *udev, lbaint_t blknr,
 			   lbaint_t blkcnt, void *buffer)
 {
@@ -804,6 +1213,8 @@ static ulong nvme_blk_write(struct udevice *udev, lbaint_t blknr,
 static const struct blk_ops nvme_blk_ops = {
 	.read	= nvme_blk_read,
 	.write	= nvme_blk_write,
+	.submit	= nvme_blk_submit,
+	.poll	= nvme_blk_poll,
 };
 
 U_BOOT_DRIVER(nvme_blk) = {
@@ -828,16 +1239,18 @@ int nvme_init(struct udevice *udev)
 		goto free_nvme;
 	}
 
-	ndev->queues = malloc(NVME_Q_NUM * sizeof(struct nvme_queue *));
+	ndev->queues = calloc(NVME_IO_Q + CONFIG_NVME_IO_QUEUES,
+			      sizeof(struct nvme_queue *));
 	if (!ndev->queues) {
 		ret = -ENOMEM;
 		printf("Error: %s: Out of memory!\n", udev->name);
 		goto free_nvme;
 	}
-	memset(ndev->queues, 0, NVME_Q_NUM * sizeof(struct nvme_queue *));
 
 	ndev->cap = nvme_readq(&ndev->bar->cap);
-	ndev->q_depth = min_t(int, NVME_CAP_MQES(ndev->cap) + 1, NVME_Q_DEPTH);
+	ndev->q_depth = min_t(int, NVME_CAP_MQES(ndev->cap) + 1,
+			      nvme_queued_io(ndev) ? CONFIG_NVME_QUEUE_DEPTH :
+			      NVME_Q_DEPTH);
 	ndev->db_stride = 1 << NVME_CAP_STRIDE(ndev->cap);
 	ndev->dbs = ((void __iomem *)ndev->bar) + 4096;
 
@@ -621,15 +621,40 @@ struct nvme_dev {
 	u64 *prp_pool;
 	u32 prp_entry_num;
 	u32 nn;
+	unsigned next_io_qid;
 };
 
-/* Admin queue and a single I/O queue. */
+/*
+ * Admin queue and the first I/O queue. Further I/O queues, if enabled, follow
+ * on from NVME_IO_Q.
+ */
 enum nvme_queue_id {
 	NVME_ADMIN_Q,
 	NVME_IO_Q,
 	NVME_Q_NUM,
 };
 
+struct nvme_io;
+
+/*
+ * An I/O command in flight on a queue. The command ID is the index of the
+ * slot in the queue's slot array.
+ */
+struct nvme_cmd_slot {
+	struct nvme_io *io;	/* transfer this command belongs to, or NULL */
+	/*
+	 * true if the command was given up on but has not completed, so that
+	 * its ID is not reused until it does
+	 */
+	bool cancelled;
+	u64 offset;		/* first block, relative to the transfer */
+	u32 len;		/* length in bytes */
+	void *buf;		/* memory being transferred */
+	bool read;
+	u64 *prp_pool;		/* PRP list for this command */
+	u32 prp_entry_num;
+};
+
 /*
  * An NVM Express queue. Each device has at least two (one for admin
  * commands and one for I/O commands).
@@ -647,6 +672,8 @@ struct nvme_queue {
 	u16 qid;
 	u8 cq_phase;
 	u8 cqe_seen;
+	u16 inflight;
+	struct nvme_cmd_slot *slots;
 	unsigned long cmdid_data[];
 };
 
@@ -9,56 +9,160 @@
 #include <common.h>
 #include <blk.h>
 #include <dm.h>
+#include <malloc.h>
 #include <part.h>
 #include <virtio_types.h>
 #include <virtio.h>
 #include <virtio_ring.h>
 #include "virtio_blk.h"
 
+static const u32 feature[] = {
+	VIRTIO_BLK_F_SIZE_MAX,
+	VIRTIO_BLK_F_SEG_MAX,
+	VIRTIO_RING_F_INDIRECT_DESC,
+};
+
+/**
+ * struct virtio_blk_req - one request slot in the virtqueue
+ *
+ * @out_hdr:	request header, also used to identify the completed request
+ * @status:	status byte written by the device
+ * @next:	next free slot
+ */
+struct virtio_blk_req {
+	struct virtio_blk_outhdr out_hdr;
+	u8 status;
+	struct virtio_blk_req *next;
+};
+
+/**
+ * struct virtio_blk_priv - private data for a virtio block device
+ *
+ * @vq:		the request virtqueue
+ * @reqs:	request slots, one per ring descriptor
+ * @free:	list of request slots not in flight
+ * @sgs:	scratch scatter-gather list used to build one request
+ * @sg_ptrs:	pointers into @sgs, as passed to virtqueue_add()
+ * @seg_max:	maximum number of data segments in one request
+ * @size_max:	maximum size in bytes of one data segment
+ */
 struct virtio_blk_priv {
 	struct virtqueue *vq;
+	struct virtio_blk_req *reqs;
+	struct virtio_blk_req *free;
+	struct virtio_sg *sgs;
+	struct virtio_sg **sg_ptrs;
+	u32 seg_max;
+	u32 size_max;
 };
 
-static ulong virtio_blk_do_req(struct udevice *dev, u64 sector,
-			       lbaint_t blkcnt, void *buffer, u32 type)
+static int virtio_blk_queue_req(struct udevice *dev, struct virtio_blk_req *req,
+				u64 sector, lbaint_t blkcnt, void *buffer,
+				u32 type)
 {
 	struct virtio_blk_priv *priv = dev_get_priv(dev);
-	unsigned int num_out = 0, num_in = 0;
-	struct virtio_sg *sgs[3];
-	u8 status;
-	int ret;
+	unsigned int num_out = 0, num_in = 0, nsegs = 0;
+	size_t len = blkcnt * 512;
+
+	req->out_hdr.type = cpu_to_virtio32(dev, type);
+	req->out_hdr.ioprio = 0;
+	req->out_hdr.sector = cpu_to_virtio64(dev, sector);
+	req->status = VIRTIO_BLK_S_IOERR;
+
+	priv->sgs[0].addr = &req->out_hdr;
+	priv->sgs[0].length = sizeof(req->out_hdr);
+
+	/* The buffer is contiguous, so each segment only needs a size limit */
+	while (len) {
+		size_t seg = min_t(size_t, len, priv->size_max);
 
-	struct virtio_blk_outhdr out_hdr = {
-		.type = cpu_to_virtio32(dev, type),
-		.sector = cpu_to_virtio64(dev, sector),
-	};
-	struct virtio_sg hdr_sg = { &out_hdr, sizeof(out_hdr) };
-	struct virtio_sg data_sg = { buffer, blkcnt * 512 };
-	struct virtio_sg status_sg = { &status, sizeof(status) };
+		priv->sgs[1 + nsegs].addr = buffer;
+		priv->sgs[1 + nsegs].length = seg;
+		buffer += seg;
+		len -= seg;
+		nsegs++;
+	}
 
-	sgs[num_out++] = &hdr_sg;
+	priv->sgs[1 + nsegs].addr = &req->status;
+	priv->sgs[1 + nsegs].length = sizeof(req->status);
 
+	num_out = 1;
 	if (type & VIRTIO_BLK_T_OUT)
-		sgs[num_out++] = &data_sg;
+		num_out += nsegs;
 	else
-		sgs[num_out + num_in++] = &data_sg;
+		num_in += nsegs;
+	num_in++;
 
-	sgs[num_out + num_in++] = &status_sg;
+	return virtqueue_add(priv->vq, priv->sg_ptrs, num_out, num_in);
+}
+
+/*
+ * Split the transfer into requests which respect the device's segment limits,
+ * queue as many of them as the ring can hold, kick the device once and then
+ * reap every completion that is ready before refilling the ring.
+ */
+static ulong virtio_blk_do_req(struct udevice *dev, u64 sector,
+			       lbaint_t blkcnt, void *buffer, u32 type)
+{
+	struct virtio_blk_priv *priv = dev_get_priv(dev);
+	struct virtio_blk_outhdr *out_hdr;
+	struct virtio_blk_req *req;
+	lbaint_t max_blocks, queued = 0;
+	uint inflight = 0;
+	bool failed = false, full = false;
+	int ret = 0;
+
+	max_blocks = max_t(u64, 1, (u64)priv->seg_max * priv->size_max / 512);
 	log_debug("dev=%s, active=%d, priv=%p, priv->vq=%p\n", dev->name,
 		  device_active(dev), priv, priv->vq);
 
-	ret = virtqueue_add(priv->vq, sgs, num_out, num_in);
-	if (ret)
-		return ret;
+	log_debug("wait...");
+	while (inflight || (queued < blkcnt && !failed && !ret)) {
+		bool added = false;
 
-	virtqueue_kick(priv->vq);
+		while (queued < blkcnt && !failed && !ret && !full &&
+		       priv->free) {
+			lbaint_t n = min(blkcnt - queued, max_blocks);
 
-	log_debug("wait...");
-	while (!virtqueue_get_buf(priv->vq, NULL))
-		;
+			req = priv->free;
+			ret = virtio_blk_queue_req(dev, req, sector + queued, n,
+						   buffer + queued * 512, type);
+			if (ret == -ENOSPC && inflight) {
+				/* Ring is full, wait for some completions */
+				full = true;
+				ret = 0;
+				break;
+			}
+			if (ret)
+				break;
+
+			priv->free = req->next;
+			queued += n;
+			inflight++;
+			added = true;
+		}
+
+		if (added)
+			virtqueue_kick(priv->vq);
+
+		while (inflight &&
+		       (out_hdr = virtqueue_get_buf(priv->vq, NULL))) {
+			req = container_of(out_hdr, struct virtio_blk_req,
+					   out_hdr);
+			if (req->status != VIRTIO_BLK_S_OK)
+				failed = true;
+			req->next = priv->free;
+			priv->free = req;
+			inflight--;
+			full = false;
+		}
+	}
 	log_debug("done\n");
 
-	return status == VIRTIO_BLK_S_OK ? blkcnt : -EIO;
+	if (ret)
+		return ret;
+
+	return failed ? -EIO : blkcnt;
 }
 
 static ulong virtio_blk_read(struct udevice *dev, lbaint_t start,
@@ -105,7 +209,8 @@ static int virtio_blk_bind(struct udevice *dev)
 	desc->bdev = dev;
 
 	/* Indicate what driver features we support */
-	virtio_driver_features_init(uc_priv, NULL, 0, NULL, 0);
+	virtio_driver_features_init(uc_priv, feature, ARRAY_SIZE(feature),
+				    NULL, 0);
 
 	return 0;
 }
@@ -114,6 +219,7 @@ static int virtio_blk_probe(struct udevice *dev)
 {
 	struct virtio_blk_priv *priv = dev_get_priv(dev);
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	unsigned int num, i;
 	u64 cap;
 	int ret;
 
@@ -126,6 +232,75 @@ static int virtio_blk_probe(struct udevice *dev)
 	virtio_cread(dev, struct virtio_blk_config, capacity, &cap);
 	desc->lba = cap;
 
+	/*
+	 * A request takes a header and a status descriptor besides its data
+	 * segments, and no chain may be longer than the ring, even if it is
+	 * indirect.
+	 */
+	num = virtqueue_get_vring_size(priv->vq);
+	priv->seg_max = num > 2 ? num - 2 : 1;
+	if (virtio_has_feature(dev, VIRTIO_BLK_F_SEG_MAX)) {
+		u32 seg_max;
+
+		virtio_cread(dev, struct virtio_blk_config, seg_max, &seg_max);
+		if (seg_max)
+			priv->seg_max = min(priv->seg_max, seg_max);
+	} else {
+		priv->seg_max = 1;
+	}
+
+	priv->size_max = U32_MAX & ~(512 - 1);
+	if (virtio_has_feature(dev, VIRTIO_BLK_F_SIZE_MAX)) {
+		u32 size_max;
+
+		virtio_cread(dev, struct virtio_blk_config, size_max,
+			     &size_max);
+		if (size_max)
+			priv->size_max = min(priv->size_max, size_max);
+	}
+
+	priv->reqs = calloc(num, sizeof(*priv->reqs));
+	priv->sgs = calloc(priv->seg_max + 2, sizeof(*priv->sgs));
+	priv->sg_ptrs = calloc(priv->seg_max + 2, sizeof(*priv->sg_ptrs));
+	if (!priv->reqs || !priv->sgs || !priv->sg_ptrs) {
+		ret = -ENOMEM;
+		goto err;
+	}
+
+	for (i = 0; i < priv->seg_max + 2; i++)
+		priv->sg_ptrs[i] = &priv->sgs[i];
+	priv->free = NULL;
+	for (i = 0; i < num; i++) {
+		priv->reqs[i].next = priv->free;
+		priv->free = &priv->reqs[i];
+	}
+	log_debug("%s: seg_max=%u size_max=%u indirect=%d\n", dev->name,
+		  priv->seg_max, priv->size_max, priv->vq->indirect);
+
+	return 0;
+
+err:
+	free(priv->reqs);
+	free(priv->sgs);
+	free(priv->sg_ptrs);
+	virtio_del_vqs(dev);
+
+	return ret;
+}
+
+static int virtio_blk_remove(struct udevice *dev)
+{
+	struct virtio_blk_priv *priv = dev_get_priv(dev);
+	int ret;
+
+	ret = virtio_reset(dev);
+	if (ret)
+		return ret;
+
+	free(priv->reqs);
+	free(priv->sgs);
+	free(priv->sg_ptrs);
+
 	return 0;
 }
 
@@ -140,7 +315,7 @@ U_BOOT_DRIVER(virtio_blk) = {
 	.ops	= &virtio_blk_ops,
 	.bind	= virtio_blk_bind,
 	.probe	= virtio_blk_probe,
-	.remove	= virtio_reset,
+	.remove	= virtio_blk_remove,
 	.priv_auto	= sizeof(struct virtio_blk_priv),
 	.flags	= DM_FLAG_ACTIVE_DMA,
 };
@@ -98,11 +98,41 @@ static void virtqueue_detach_desc(struct virtqueue *vq, unsigned int idx)
 	desc->addr = cpu_to_virtio64(vq->vdev, (u64)(uintptr_t)bb->user_buffer);
 }
 
+static struct vring_desc *virtqueue_alloc_indirect(struct virtqueue *vq,
+						   struct virtio_sg *sgs[],
+						   unsigned int out_sgs,
+						   unsigned int total_sg)
+{
+	struct vring_desc *indir;
+	unsigned int n;
+
+	indir = malloc(total_sg * sizeof(*indir));
+	if (!indir)
+		return NULL;
+
+	for (n = 0; n < total_sg; n++) {
+		u16 flags = 0;
+
+		if (n + 1 < total_sg)
+			flags |= VRING_DESC_F_NEXT;
+		if (n >= out_sgs)
+			flags |= VRING_DESC_F_WRITE;
+		indir[n].addr = cpu_to_virtio64(vq->vdev,
+						(u64)(uintptr_t)sgs[n]->addr);
+		indir[n].len = cpu_to_virtio32(vq->vdev, sgs[n]->length);
+		indir[n].flags = cpu_to_virtio16(vq->vdev, flags);
+		indir[n].next = cpu_to_virtio16(vq->vdev, n + 1);
+	}
+
+	return indir;
+}
+
 int virtqueue_add(struct virtqueue *vq, struct virtio_sg *sgs[],
 		  unsigned int out_sgs, unsigned int in_sgs)
 {
-	struct vring_desc *desc;
-	unsigned int descs_used = out_sgs + in_sgs;
+	struct vring_desc *desc, *indir = NULL;
+	unsigned int total_sg = out_sgs + in_sgs;
+	unsigned int descs_used = total_sg;
 	unsigned int i, n, avail, uninitialized_var(prev);
 	int head;
 
@@ -113,9 +143,17 @@ int virtqueue_add(struct virtqueue *vq, struct virtio_sg *sgs[],
 	desc = vq->vring.desc;
 	i = head;
 
+	/* A chain of several buffers only needs one ring slot when indirect */
+	if (vq->indirect && total_sg > 1) {
+		indir = virtqueue_alloc_indirect(vq, sgs, out_sgs, total_sg);
+		if (indir)
+			descs_used = 1;
+	}
+
 	if (vq->num_free < descs_used) {
 		debug("Can't add buf len %i - avail = %i\n",
 		      descs_used, vq->num_free);
+		free(indir);
 		/*
 		 * FIXME: for historical reasons, we force a notify here if
 		 * there are outgoing parts to the buffer.  Presumably the
@@ -126,17 +164,27 @@ int virtqueue_add(struct virtqueue *vq, struct virtio_sg *sgs[],
 		return -ENOSPC;
 	}
 
-	for (n = 0; n < descs_used; n++) {
-		u16 flags = VRING_DESC_F_NEXT;
+	if (indir) {
+		struct virtio_sg indir_sg = {
+			indir, total_sg * sizeof(*indir)
+		};
 
-		if (n >= out_sgs)
-			flags |= VRING_DESC_F_WRITE;
-		prev = i;
-		i = virtqueue_attach_desc(vq, i, sgs[n], flags);
+		i = virtqueue_attach_desc(vq, i, &indir_sg,
+					  VRING_DESC_F_INDIRECT);
+	} else {
+		for (n = 0; n < descs_used; n++) {
+			u16 flags = VRING_DESC_F_NEXT;
+
+			if (n >= out_sgs)
+				flags |= VRING_DESC_F_WRITE;
+			prev = i;
+			i = virtqueue_attach_desc(vq, i, sgs[n], flags);
+		}
+		/* Last one doesn't continue */
+		vq->vring_desc_shadow[prev].flags &= ~VRING_DESC_F_NEXT;
+		desc[prev].flags = cpu_to_virtio16(vq->vdev,
+						   vq->vring_desc_shadow[prev].flags);
 	}
-	/* Last one doesn't continue */
-	vq->vring_desc_shadow[prev].flags &= ~VRING_DESC_F_NEXT;
-	desc[prev].flags = cpu_to_virtio16(vq->vdev, vq->vring_desc_shadow[prev].flags);
 
 	/* We're using some buffers from the free list. */
 	vq->num_free -= descs_used;
@@ -146,6 +194,8 @@ int virtqueue_add(struct virtqueue *vq, struct virtio_sg *sgs[],
 
 	/* Mark the descriptor as the head of a chain. */
 	vq->vring_desc_shadow[head].chain_head = true;
+	vq->vring_desc_shadow[head].indir = indir;
+	vq->vring_desc_shadow[head].data = sgs[0]->addr;
 
 	/*
 	 * Put entry in available array (but don't update avail->idx
@@ -212,6 +262,10 @@ static void detach_buf(struct virtqueue *vq, unsigned int head)
 	/* Unmark the descriptor as the head of a chain. */
 	vq->vring_desc_shadow[head].chain_head = false;
 
+	/* Indirect tables are only ever read by the device */
+	free(vq->vring_desc_shadow[head].indir);
+	vq->vring_desc_shadow[head].indir = NULL;
+
 	/* Put back on free list: unmap first-level descriptors and find end */
 	i = head;
 
@@ -239,6 +293,7 @@ void *virtqueue_get_buf(struct virtqueue *vq, unsigned int *len)
 {
 	unsigned int i;
 	u16 last_used;
+	void *data;
 
 	if (!more_used(vq)) {
 		debug("(%s.%d): No more buffers in queue\n",
@@ -270,6 +325,9 @@ void *virtqueue_get_buf(struct virtqueue *vq, unsigned int *len)
 		return NULL;
 	}
 
+	/* The shadow address may be a bounce buffer, freed by detach_buf() */
+	data = vq->vring_desc_shadow[i].data;
+
 	detach_buf(vq, i);
 	vq->last_used_idx++;
 	/*
@@ -281,7 +339,7 @@ void *virtqueue_get_buf(struct virtqueue *vq, unsigned int *len)
 		virtio_store_mb(&vring_used_event(&vq->vring),
 				cpu_to_virtio16(vq->vdev, vq->last_used_idx));
 
-	return (void *)(uintptr_t)vq->vring_desc_shadow[i].addr;
+	return data;
 }
 
 static struct virtqueue *__vring_new_virtqueue(unsigned int index,
@@ -317,6 +375,10 @@ static struct virtqueue *__vring_new_virtqueue(unsigned int index,
 
 	vq->event = virtio_has_feature(vdev, VIRTIO_RING_F_EVENT_IDX);
 
+	/* Indirect tables are not set up for bounce buffering */
+	vq->indirect = virtio_has_feature(vdev, VIRTIO_RING_F_INDIRECT_DESC) &&
+		       !vring.bouncebufs;
+
 	/* Tell other side not to bother us */
 	vq->avail_flags_shadow |= VRING_AVAIL_F_NO_INTERRUPT;
 	if (!vq->event)
@@ -395,6 +457,10 @@ err_free_queue:
 
 void vring_del_virtqueue(struct virtqueue *vq)
 {
+	unsigned int i;
+
+	for (i = 0; i < vq->vring.num; i++)
+		free(vq->vring_desc_shadow[i].indir);
 	virtio_free_pages(vq->vdev, vq->vring.desc,
 			  DIV_ROUND_UP(vq->vring.size, PAGE_SIZE));
 	free(vq->vring_desc_shadow);
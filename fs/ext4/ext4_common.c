@@ -1530,10 +1530,15 @@ void ext4fs_allocate_blocks(struct ext2_inode *file_inode,
 
 #endif
 
+/*
+ * Find the extent leaf covering @fileblock. If @limit is not NULL it is
+ * lowered to the first logical block covered by a later leaf, so that callers
+ * know how far a hole after the leaf's last extent reaches.
+ */
 static struct ext4_extent_header *ext4fs_get_extent_block
 	(struct ext2_data *data, struct ext_block_cache *cache,
 		struct ext4_extent_header *ext_block,
-		uint32_t fileblock, int log2_blksz)
+		uint32_t fileblock, int log2_blksz, uint32_t *limit)
 {
 	struct ext4_extent_idx *index;
 	unsigned long long block;
@@ -1555,6 +1560,9 @@ static struct ext4_extent_header *ext4fs_get_extent_block
 				break;
 		} while (fileblock >= le32_to_cpu(index[i].ei_block));
 
+		if (limit && i < le16_to_cpu(ext_block->eh_entries))
+			*limit = min(*limit, le32_to_cpu(index[i].ei_block));
+
 		/*
 		 * If first logical block number is higher than requested fileblock,
 		 * it is a sparse file. This is handled on upper layer.
@@ -1647,6 +1655,72 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 	return 1;
 }
 
+/*
+ * Map @fileblock of an extent-mapped inode. On success *count is set to the
+ * number of blocks from @fileblock which are either physically contiguous,
+ * starting at *blknr, or a hole, in which case *blknr is 0.
+ */
+int ext4fs_map_extent(struct ext2_inode *inode, uint32_t fileblock,
+		      struct ext_block_cache *cache, uint64_t *blknr,
+		      uint32_t *count)
+{
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent *extent;
+	uint32_t limit = U32_MAX;
+	int log2_blksz;
+	int i;
+
+	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root) -
+		get_fs()->dev_desc->log2blksz;
+	ext_block = ext4fs_get_extent_block(ext4fs_root, cache,
+					    (struct ext4_extent_header *)
+					    inode->b.blocks.dir_blocks,
+					    fileblock, log2_blksz, &limit);
+	if (!ext_block) {
+		printf("invalid extent block\n");
+		return -EINVAL;
+	}
+
+	extent = (struct ext4_extent *)(ext_block + 1);
+	*blknr = 0;
+
+	for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
+		uint32_t startblock = le32_to_cpu(extent[i].ee_block);
+		uint32_t len = le16_to_cpu(extent[i].ee_len);
+		bool unwritten = false;
+
+		if (startblock > fileblock) {
+			/* Hole up to the next extent */
+			limit = startblock;
+			break;
+		}
+
+		if (len > EXT_INIT_MAX_LEN) {
+			len -= EXT_INIT_MAX_LEN;
+			unwritten = true;
+		}
+		if (fileblock - startblock >= len)
+			continue;
+
+		*count = len - (fileblock - startblock);
+		/* Unwritten extents are allocated but read back as zeroes */
+		if (!unwritten) {
+			*blknr = le16_to_cpu(extent[i].ee_start_hi);
+			*blknr = (*blknr << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+			*blknr += fileblock - startblock;
+		}
+
+		return 0;
+	}
+
+	*count = limit - fileblock;
+	if (!*count)
+		*count = 1;
+
+	return 0;
+}
+
 long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 			      struct ext_block_cache *cache)
 {
@@ -1680,7 +1754,7 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 			ext4fs_get_extent_block(ext4fs_root, c,
 						(struct ext4_extent_header *)
 						inode->b.blocks.dir_blocks,
-						fileblock, log2_blksz);
+						fileblock, log2_blksz, NULL);
 		if (!ext_block) {
 			printf("invalid extent block\n");
 			if (!cache)
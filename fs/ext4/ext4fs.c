@@ -44,6 +44,63 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
 		free(node);
 }
 
+/* Largest single device read issued for one extent, in bytes */
+#define EXT4_MAX_EXTENT_READ	(1 << 30)
+
+/*
+ * Read path for extent-mapped files: each extent is looked up once and read
+ * straight into the destination buffer, holes are zeroed.
+ */
+static int ext4fs_read_extents(struct ext2fs_node *node, loff_t pos,
+			       loff_t len, char *buf)
+{
+	struct ext_filesystem *fs = get_fs();
+	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data);
+	int log2_sects = log2_fs_blocksize - fs->dev_desc->log2blksz;
+	uint32_t fileblock = pos >> log2_fs_blocksize;
+	int skipfirst = pos & ((1 << log2_fs_blocksize) - 1);
+	struct ext_block_cache cache;
+	int ret = 0;
+
+	ext_cache_init(&cache);
+
+	while (len > 0) {
+		uint64_t blknr;
+		uint32_t count;
+		loff_t bytes;
+
+		ret = ext4fs_map_extent(&node->inode, fileblock, &cache,
+					&blknr, &count);
+		if (ret)
+			break;
+
+		count = min_t(uint32_t, count,
+			      EXT4_MAX_EXTENT_READ >> log2_fs_blocksize);
+		bytes = ((loff_t)count << log2_fs_blocksize) - skipfirst;
+		if (bytes > len)
+			bytes = len;
+
+		if (blknr) {
+			if (!ext4fs_devread((lbaint_t)blknr << log2_sects,
+					    skipfirst, bytes, buf)) {
+				ret = -EIO;
+				break;
+			}
+		} else {
+			memset(buf, 0, bytes);
+		}
+
+		buf += bytes;
+		len -= bytes;
+		fileblock += count;
+		skipfirst = 0;
+	}
+
+	ext_cache_fini(&cache);
+
+	return ret;
+}
+
 /*
  * Taken from openmoko-kernel mailing list: By Andy green
  * Optimized read file API : collects and defers contiguous sector
@@ -80,6 +137,14 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		return -1;
 	}
 
+	if (le32_to_cpu(node->inode.flags) & EXT4_EXTENTS_FL) {
+		ext_cache_fini(&cache);
+		if (ext4fs_read_extents(node, pos, len, buf))
+			return -1;
+		*actread = len;
+		return 0;
+	}
+
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
 
 	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
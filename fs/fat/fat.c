@@ -39,6 +39,38 @@ static void downcase(char *str, size_t len)
 static struct blk_desc *cur_dev;
 static struct disk_partition cur_part_info;
 
+/**
+ * struct fat_run - run of physically contiguous clusters
+ *
+ * @clust:	first cluster of the run
+ * @count:	number of clusters in the run
+ */
+struct fat_run {
+	__u32 clust;
+	__u32 count;
+};
+
+/*
+ * Cluster chain of the file read last, as a list of contiguous runs. It is
+ * extended on demand and kept across reads of the same file while the file
+ * system is open, so that seeking and large reads need neither FAT lookups
+ * nor per-cluster disk reads. It is dropped when the device is set up again,
+ * since the medium may have changed in the meantime.
+ */
+static struct {
+	__u32 start;		/* first cluster of the file, 0 if unused */
+	__u32 nclust;		/* clusters covered by runs[] */
+	int nruns;
+	int max_runs;
+	struct fat_run *runs;
+} fat_chain;
+
+static void fat_chain_invalidate(void)
+{
+	free(fat_chain.runs);
+	memset(&fat_chain, '\0', sizeof(fat_chain));
+}
+
 #define DOS_BOOT_MAGIC_OFFSET	0x1fe
 #define DOS_FS_TYPE_OFFSET	0x36
 #define DOS_FS32_TYPE_OFFSET	0x52
@@ -62,6 +94,7 @@ int fat_set_blk_dev(struct blk_desc *dev_desc, struct disk_partition *info)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, buffer, dev_desc->blksz);
 
+	fat_chain_invalidate();
 	cur_dev = dev_desc;
 	cur_part_info = *info;
 
@@ -304,6 +337,65 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	return 0;
 }
 
+/**
+ * fat_chain_map() - map the first clusters of a file
+ *
+ * Make sure fat_chain holds the runs for at least the first @nclust clusters
+ * of the cluster chain beginning at @start.
+ *
+ * @mydata:	file system description
+ * @start:	first cluster of the file
+ * @nclust:	number of clusters needed
+ * Return:	-1 on error, otherwise 0
+ */
+static int fat_chain_map(fsdata *mydata, __u32 start, __u32 nclust)
+{
+	struct fat_run *run;
+	__u32 clust;
+
+	if (fat_chain.start != start) {
+		fat_chain.start = start;
+		fat_chain.nclust = 0;
+		fat_chain.nruns = 0;
+	}
+
+	while (fat_chain.nclust < nclust) {
+		run = fat_chain.runs + fat_chain.nruns - 1;
+		if (fat_chain.nruns)
+			clust = get_fatent(mydata, run->clust + run->count - 1);
+		else
+			clust = start;
+		if (CHECK_CLUST(clust, mydata->fatsize)) {
+			debug("curclust: 0x%x\n", clust);
+			printf("Invalid FAT entry\n");
+			return -1;
+		}
+
+		if (fat_chain.nruns && clust == run->clust + run->count) {
+			run->count++;
+		} else {
+			if (fat_chain.nruns == fat_chain.max_runs) {
+				int max_runs = max(fat_chain.max_runs * 2, 16);
+
+				run = realloc(fat_chain.runs,
+					      max_runs * sizeof(*run));
+				if (!run) {
+					debug("Error: allocating cluster runs\n");
+					return -1;
+				}
+				fat_chain.runs = run;
+				fat_chain.max_runs = max_runs;
+			}
+			run = &fat_chain.runs[fat_chain.nruns++];
+			run->clust = clust;
+			run->count = 1;
+		}
+		fat_chain.nclust++;
+	}
+
+	return 0;
+}
+
 /**
  * get_contents() - read from file
  *
@@ -324,8 +416,8 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 {
 	loff_t filesize = FAT2CPU32(dentptr->size);
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
-	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
+	struct fat_run *run;
+	__u32 curclust, left, skip;
 	loff_t actsize;
 
 	*gotsize = 0;
@@ -341,23 +433,24 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 
 	debug("%llu bytes\n", filesize);
 
-	actsize = bytesperclust;
+	if (fat_chain_map(mydata, START(dentptr),
+			  ((__u32)filesize - 1) / bytesperclust + 1))
+		return -1;
 
-	/* go to cluster at pos */
-	while (actsize <= pos) {
-		curclust = get_fatent(mydata, curclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
-			return -1;
-		}
-		actsize += bytesperclust;
+	/* go to the run holding pos */
+	run = fat_chain.runs;
+	while (pos >= (actsize = (loff_t)run->count * bytesperclust)) {
+		filesize -= actsize;
+		pos -= actsize;
+		run++;
 	}
 
-	/* actsize > pos */
-	actsize -= bytesperclust;
-	filesize -= actsize;
-	pos -= actsize;
+	/* go to cluster at pos */
+	skip = (__u32)pos / bytesperclust;
+	curclust = run->clust + skip;
+	left = run->count - skip;
+	filesize -= (loff_t)skip * bytesperclust;
+	pos -= (loff_t)skip * bytesperclust;
 
 	/* align to beginning of next cluster if any */
 	if (pos) {
@@ -380,62 +473,31 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 		memcpy(buffer, tmp_buffer + pos, actsize);
 		free(tmp_buffer);
 		*gotsize += actsize;
-		if (!filesize)
-			return 0;
 		buffer += actsize;
-
-		curclust = get_fatent(mydata, curclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
-			return -1;
-		}
+		curclust++;
+		left--;
 	}
 
-	actsize = bytesperclust;
-	endclust = curclust;
-
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				printf("Invalid FAT entry\n");
-				return -1;
-			}
-			endclust = newclust;
-			actsize += bytesperclust;
+	/* read whole runs of consecutive clusters */
+	while (filesize > 0) {
+		if (!left) {
+			run++;
+			curclust = run->clust;
+			left = run->count;
 		}
 
-		/* get remaining bytes */
-		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+		actsize = min(filesize, (loff_t)left * bytesperclust);
+		if (get_cluster(mydata, curclust, buffer, actsize) != 0) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
 		*gotsize += actsize;
-		return 0;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		*gotsize += (int)actsize;
 		filesize -= actsize;
 		buffer += actsize;
+		left = 0;
+	}
 
-		curclust = get_fatent(mydata, endclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
-			return -1;
-		}
-		actsize = bytesperclust;
-		endclust = curclust;
-	} while (1);
+	return 0;
 }
 
 /*
@@ -1362,6 +1424,7 @@ void fat_closedir(struct fs_dir_stream *dirs)
 
 void fat_close(void)
 {
+	fat_chain_invalidate();
 }
 
 int fat_uuid(char *uuid_str)
@@ -443,6 +443,9 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 	__u32 bufnum, offset, off16;
 	__u16 val1, val2;
 
+	/* Any cluster chain may change, forget the one cached for reading */
+	fat_chain_invalidate();
+
 	switch (mydata->fatsize) {
 	case 32:
 		bufnum = entry / FAT32BUFSIZE;
@@ -11,6 +11,7 @@
 #include <errno.h>
 #include <common.h>
 #include <env.h>
+#include <hash.h>
 #include <lmb.h>
 #include <log.h>
 #include <mapmem.h>
@@ -821,6 +822,10 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	env_set_hex("fileaddr", addr);
 	env_set_hex("filesize", len_read);
 
+	/* the filesystem reads the whole file at once, so hash it now */
+	if (!hash_load_start(addr))
+		hash_load_finish(len_read);
+
 	return 0;
 }
 
@@ -20,6 +20,7 @@
 #include <squashfs.h>
 #include <part.h>
 
+#include "sqfs_cache.h"
 #include "sqfs_decompressor.h"
 #include "sqfs_filesystem.h"
 #include "sqfs_utils.h"
@@ -182,8 +183,8 @@ static int sqfs_frag_lookup(u32 inode_fragment_index,
 	if (SQFS_COMPRESSED_METADATA(header)) {
 		src_len = SQFS_METADATA_SIZE(header);
 		dest_len = SQFS_METADATA_BLOCK_SIZE;
-		ret = sqfs_decompress(&ctxt, entries, &dest_len, metadata,
-				      src_len);
+		ret = sqfs_cache_decompress(&ctxt, start_block, entries,
+					    &dest_len, metadata, src_len);
 		if (ret) {
 			ret = -EINVAL;
 			goto out;
@@ -748,9 +749,12 @@ static int sqfs_read_inode_table(unsigned char **inode_table)
 		sqfs_read_metablock(itb, table_offset, &compressed, &src_len);
 		if (compressed) {
 			dest_len = SQFS_METADATA_BLOCK_SIZE;
-			ret = sqfs_decompress(&ctxt, *inode_table +
-					      dest_offset, &dest_len,
-					      src_table, src_len);
+			ret = sqfs_cache_decompress(&ctxt, start *
+						    ctxt.cur_dev->blksz +
+						    table_offset,
+						    *inode_table + dest_offset,
+						    &dest_len, src_table,
+						    src_len);
 			if (ret) {
 				free(*inode_table);
 				*inode_table = NULL;
@@ -839,9 +843,12 @@ static int sqfs_read_directory_table(unsigned char **dir_table, u32 **pos_list)
 		sqfs_read_metablock(dtb, table_offset, &compressed, &src_len);
 		if (compressed) {
 			dest_len = SQFS_METADATA_BLOCK_SIZE;
-			ret = sqfs_decompress(&ctxt, *dir_table +
-					      (j * SQFS_METADATA_BLOCK_SIZE),
-					      &dest_len, src_table, src_len);
+			ret = sqfs_cache_decompress(&ctxt, start *
+						    ctxt.cur_dev->blksz +
+						    table_offset, *dir_table +
+						    (j * SQFS_METADATA_BLOCK_SIZE),
+						    &dest_len, src_table,
+						    src_len);
 			if (ret) {
 				metablks_count = -1;
 				goto out;
@@ -1108,6 +1115,7 @@ int sqfs_probe(struct blk_desc *fs_dev_desc, struct disk_partition *fs_partition
 	}
 
 	ctxt.sblk = sblk;
+	sqfs_cache_invalidate();
 
 	ret = sqfs_decompressor_init(&ctxt);
 	if (ret) {
@@ -1526,6 +1534,18 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 		goto out;
 	}
 
+	/* Fragment blocks are shared by small files, reuse a cached copy */
+	if (finfo.comp) {
+		fragment_block = sqfs_cache_get(frag_entry.start, &dest_len);
+		if (fragment_block) {
+			memcpy(buf + *actread, &fragment_block[finfo.offset],
+			       finfo.size - *actread);
+			*actread = finfo.size;
+			ret = 0;
+			goto out;
+		}
+	}
+
 	start = lldiv(frag_entry.start, ctxt.cur_dev->blksz);
 	table_size = SQFS_BLOCK_SIZE(frag_entry.size);
 	table_offset = frag_entry.start - (start * ctxt.cur_dev->blksz);
@@ -1558,6 +1578,7 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 			free(fragment_block);
 			goto out;
 		}
+		sqfs_cache_put(frag_entry.start, fragment_block, dest_len);
 
 		memcpy(buf + *actread, &fragment_block[finfo.offset], finfo.size - *actread);
 		*actread = finfo.size;
@@ -1711,6 +1732,7 @@ free_strings:
 
 void sqfs_close(void)
 {
+	sqfs_cache_invalidate();
 	sqfs_decompressor_cleanup(&ctxt);
 	free(ctxt.sblk);
 	ctxt.sblk = NULL;
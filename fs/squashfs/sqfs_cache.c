@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Cache of decompressed SquashFS metadata and fragment blocks
+ *
+ * Every filesystem operation decompresses the inode and directory tables
+ * again, and every read of a small file decompresses a whole fragment block.
+ * Keep the most recently used decompressed blocks, keyed by the offset of the
+ * compressed block on disk, so that they are only decompressed once.
+ *
+ * The device may be written between commands, perhaps with an image which has
+ * the same superblock, so the cache only lasts from probe to close.
+ */
+
+#include <malloc.h>
+#include <string.h>
+#include <linux/list.h>
+
+#include "sqfs_cache.h"
+#include "sqfs_decompressor.h"
+#include "sqfs_filesystem.h"
+
+/**
+ * struct sqfs_cache_entry - a decompressed block
+ *
+ * @list:	position in the LRU list, most recently used first
+ * @offset:	byte offset of the compressed block in the partition
+ * @len:	decompressed size
+ * @data:	decompressed data
+ */
+struct sqfs_cache_entry {
+	struct list_head list;
+	u64 offset;
+	unsigned long len;
+	u8 data[];
+};
+
+static LIST_HEAD(sqfs_cache);
+static unsigned long sqfs_cache_used;
+
+static void sqfs_cache_evict(struct sqfs_cache_entry *entry)
+{
+	list_del(&entry->list);
+	sqfs_cache_used -= entry->len;
+	free(entry);
+}
+
+void sqfs_cache_invalidate(void)
+{
+	struct sqfs_cache_entry *entry, *n;
+
+	list_for_each_entry_safe(entry, n, &sqfs_cache, list)
+		sqfs_cache_evict(entry);
+}
+
+void *sqfs_cache_get(u64 offset, unsigned long *len)
+{
+	struct sqfs_cache_entry *entry;
+
+	list_for_each_entry(entry, &sqfs_cache, list) {
+		if (entry->offset == offset) {
+			list_move(&entry->list, &sqfs_cache);
+			*len = entry->len;
+			return entry->data;
+		}
+	}
+
+	return NULL;
+}
+
+void sqfs_cache_put(u64 offset, const void *data, unsigned long len)
+{
+	struct sqfs_cache_entry *entry;
+
+	if (!len || len > CONFIG_VAL(SQUASHFS_CACHE_SIZE))
+		return;
+
+	while (sqfs_cache_used + len > CONFIG_VAL(SQUASHFS_CACHE_SIZE))
+		sqfs_cache_evict(list_last_entry(&sqfs_cache,
+						 struct sqfs_cache_entry,
+						 list));
+
+	entry = malloc(sizeof(*entry) + len);
+	if (!entry)
+		return;
+
+	entry->offset = offset;
+	entry->len = len;
+	memcpy(entry->data, data, len);
+	list_add(&entry->list, &sqfs_cache);
+	sqfs_cache_used += len;
+}
+
+int sqfs_cache_decompress(struct squashfs_ctxt *ctxt, u64 offset, void *dest,
+			  unsigned long *dest_len, void *source, u32 src_len)
+{
+	unsigned long len;
+	void *data;
+	int ret;
+
+	data = sqfs_cache_get(offset, &len);
+	if (data && len <= *dest_len) {
+		memcpy(dest, data, len);
+		*dest_len = len;
+		return 0;
+	}
+
+	ret = sqfs_decompress(ctxt, dest, dest_len, source, src_len);
+	if (!ret)
+		sqfs_cache_put(offset, dest, *dest_len);
+
+	return ret;
+}
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Cache of decompressed SquashFS metadata and fragment blocks
+ */
+
+#ifndef SQFS_CACHE_H
+#define SQFS_CACHE_H
+
+#include <linux/types.h>
+
+struct squashfs_ctxt;
+
+/**
+ * sqfs_cache_invalidate() - drop all cached blocks
+ *
+ * Must be called when a filesystem is probed and closed, so that blocks of a
+ * previous device, partition or image are never returned, even if the device
+ * has been written since.
+ */
+void sqfs_cache_invalidate(void);
+
+/**
+ * sqfs_cache_get() - look up a decompressed block
+ *
+ * @offset:	byte offset of the compressed block in the partition
+ * @len:	returns the decompressed size of the block
+ * Return:	cached data, valid until the next sqfs_cache_put(), or NULL
+ */
+void *sqfs_cache_get(u64 offset, unsigned long *len);
+
+/**
+ * sqfs_cache_put() - add a copy of a decompressed block to the cache
+ *
+ * Least recently used blocks are evicted to keep the cache within
+ * CONFIG_SQUASHFS_CACHE_SIZE, or CONFIG_SPL_SQUASHFS_CACHE_SIZE in SPL.
+ * Nothing is cached if the block does not fit.
+ *
+ * @offset:	byte offset of the compressed block in the partition
+ * @data:	decompressed data
+ * @len:	decompressed size
+ */
+void sqfs_cache_put(u64 offset, const void *data, unsigned long len);
+
+/**
+ * sqfs_cache_decompress() - decompress a block, reusing a cached copy
+ *
+ * Same as sqfs_decompress(), except that @offset identifies the block so
+ * that it is only decompressed the first time it is needed.
+ *
+ * @ctxt:	SquashFS context
+ * @offset:	byte offset of the compressed block in the partition
+ * @dest:	destination buffer
+ * @dest_len:	size of @dest, updated with the decompressed size
+ * @source:	compressed data
+ * @src_len:	size of the compressed data
+ * Return:	0 if OK, -ve on error
+ */
+int sqfs_cache_decompress(struct squashfs_ctxt *ctxt, u64 offset, void *dest,
+			  unsigned long *dest_len, void *source, u32 src_len);
+
+#endif /* SQFS_CACHE_H */
@@ -217,6 +217,27 @@ struct global_data {
 	 * @uclass_root_s.
 	 */
 	struct list_head *uclass_root;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	/**
+	 * @dm_index: lookup tables for uclasses and devices, see
+	 * CONFIG_DM_UCLASS_INDEX. This is NULL before relocation.
+	 */
+	struct dm_index *dm_index;
+#endif
+#if CONFIG_IS_ENABLED(DM_TIMING)
+	/**
+	 * @dm_timing_nested: time spent binding and probing other devices
+	 * while the current device is bound or probed, in microseconds
+	 */
+	ulong dm_timing_nested;
+#endif
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+	/**
+	 * @dm_compat: hash table of driver compatible strings, see
+	 * CONFIG_DM_COMPAT_HASH. It is rebuilt after relocation.
+	 */
+	struct dm_compat_table *dm_compat;
+#endif
 # if CONFIG_IS_ENABLED(OF_PLATDATA_DRIVER_RT)
 	/** @dm_driver_rt: Dynamic info about the driver */
 	struct driver_rt *dm_driver_rt;
@@ -260,6 +281,21 @@ struct global_data {
 	 */
 	struct device_node *of_root;
 #endif
+#if CONFIG_IS_ENABLED(OF_LOOKUP_INDEX)
+	/**
+	 * @fdt_phandle_index: phandle lookup table for @fdt_blob, see
+	 * fdtdec_node_offset_by_phandle()
+	 */
+	struct fdtdec_phandle_index *fdt_phandle_index;
+#endif
+#if CONFIG_IS_ENABLED(OFNODE_PROP_CACHE)
+	/**
+	 * @ofnode_prop_cache: offsets of properties recently read from
+	 * @fdt_blob, see CONFIG_OFNODE_PROP_CACHE. It is rebuilt after
+	 * relocation.
+	 */
+	struct ofnode_prop_cache *ofnode_prop_cache;
+#endif
 
 #if CONFIG_IS_ENABLED(MULTI_DTB_FIT)
 	/**
@@ -126,6 +126,25 @@ int blkcache_read(int iftype, int dev,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer);
 
+/**
+ * blkcache_readahead() - decide how many blocks to read after a cache miss
+ *
+ * When a device is being read sequentially, a small read which missed the
+ * cache can be enlarged so that the following reads are satisfied from the
+ * cache. The window grows with each sequential miss, up to the configured
+ * readahead size.
+ *
+ * @param iftype - uclass_id_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number
+ * @param blkcnt - number of blocks requested
+ *
+ * Return: number of blocks to read from the device, at least @blkcnt. The
+ * caller must limit this to the size of the device.
+ */
+lbaint_t blkcache_readahead(int iftype, int dev,
+			    lbaint_t start, lbaint_t blkcnt);
+
 /**
  * blkcache_fill() - make data read from a block device available
  * to the block cache
@@ -154,20 +173,43 @@ void blkcache_invalidate(int iftype, int dev);
 /**
  * blkcache_configure() - configure block cache
  *
- * @param blocks - maximum blocks per entry
+ * @param blocks - maximum blocks per entry, rounded down to a power of two
  * @param entries - maximum entries in cache
  */
 void blkcache_configure(unsigned blocks, unsigned entries);
 
+/**
+ * blkcache_configure_size() - configure block cache memory and readahead
+ *
+ * @param size - maximum number of bytes of cached data
+ * @param readahead - maximum number of blocks to read ahead, 0 to disable
+ */
+void blkcache_configure_size(unsigned long size, unsigned readahead);
+
 /*
  * statistics of the block cache
  */
 struct block_cache_stats {
 	unsigned hits;
 	unsigned misses;
+	unsigned readaheads;
 	unsigned entries; /* current entry count */
+	unsigned long size; /* current number of bytes cached */
 	unsigned max_blocks_per_entry;
 	unsigned max_entries;
+	unsigned long max_size;
+	unsigned readahead_blocks;
+};
+
+/*
+ * per-device statistics of the block cache
+ */
+struct block_cache_dev_stats {
+	int iftype;
+	int devnum;
+	unsigned hits;
+	unsigned misses;
+	unsigned readaheads;
 };
 
 /**
@@ -177,6 +219,15 @@ struct block_cache_stats {
  */
 void blkcache_stats(struct block_cache_stats *stats);
 
+/**
+ * blkcache_dev_stats() - return statistics for one device and reset
+ *
+ * @param index - index of the device, in order of first use
+ * @param stats - statistics are copied here
+ * Return: 0 if OK, -ENOENT if @index is past the last device
+ */
+int blkcache_dev_stats(int index, struct block_cache_dev_stats *stats);
+
 /** blkcache_free() - free all memory allocated to the block cache */
 void blkcache_free(void);
 
@@ -189,6 +240,12 @@ static inline int blkcache_read(int iftype, int dev,
 	return 0;
 }
 
+static inline lbaint_t blkcache_readahead(int iftype, int dev,
+					  lbaint_t start, lbaint_t blkcnt)
+{
+	return blkcnt;
+}
+
 static inline void blkcache_fill(int iftype, int dev,
 				 lbaint_t start, lbaint_t blkcnt,
 				 unsigned long blksz, void const *buffer) {}
@@ -202,6 +259,62 @@ static inline void blkcache_free(void) {}
 #if CONFIG_IS_ENABLED(BLK)
 struct udevice;
 
+/**
+ * struct blk_sg - one segment of a block I/O request
+ *
+ * @buf:	Memory to transfer to or from
+ * @blkcnt:	Number of blocks to transfer
+ */
+struct blk_sg {
+	void *buf;
+	lbaint_t blkcnt;
+};
+
+/**
+ * enum blk_req_op - operation carried out by a block I/O request
+ *
+ * @BLK_REQ_READ:	Read from the device into the segments
+ * @BLK_REQ_WRITE:	Write the segments to the device
+ */
+enum blk_req_op {
+	BLK_REQ_READ,
+	BLK_REQ_WRITE,
+};
+
+/**
+ * struct blk_request - a queued block I/O request
+ *
+ * A request transfers a run of consecutive blocks, starting at @start, to or
+ * from a list of memory segments. It is submitted with blk_submit() and stays
+ * owned by the block device until it completes, so it must not be changed or
+ * freed before then. Completion is reported through blk_request_done(), which
+ * drivers call from their submit() or poll() methods.
+ *
+ * @dev:	Block device the request was submitted to (set by blk_submit())
+ * @op:	Operation to perform
+ * @start:	First block to transfer
+ * @sg:	List of segments, transferred in order
+ * @sg_count:	Number of segments in @sg
+ * @status:	-EINPROGRESS while the request is in flight, then 0 if all
+ *		blocks were transferred, or -ve on error
+ * @blkcnt_done: Number of blocks transferred, valid on completion
+ * @complete:	Function to call on completion, or NULL
+ * @priv:	Private data for the submitter, e.g. for use in @complete
+ * @drv_priv:	Private data for the driver while the request is in flight
+ */
+struct blk_request {
+	struct udevice *dev;
+	enum blk_req_op op;
+	lbaint_t start;
+	struct blk_sg *sg;
+	uint sg_count;
+	int status;
+	lbaint_t blkcnt_done;
+	void (*complete)(struct blk_request *req);
+	void *priv;
+	void *drv_priv;
+};
+
 /* Operations on block devices */
 struct blk_ops {
 	/**
@@ -260,6 +373,34 @@ struct blk_ops {
 	 * @return 0 if OK, -ve on error
 	 */
 	int (*select_hwpart)(struct udevice *dev, int hwpart);
+
+	/**
+	 * submit() - queue a block I/O request
+	 *
+	 * Starts the transfer described by @req without waiting for it to
+	 * finish. The driver must eventually call blk_request_done() for
+	 * the request, either from this method or from poll(). If this
+	 * method is not provided, requests are carried out synchronously
+	 * using read() and write().
+	 *
+	 * @dev:	Block device to use
+	 * @req:	Request to queue
+	 * @return 0 if queued, -EBUSY if the device cannot accept any more
+	 * requests until some have completed, -ENOSYS to carry out this
+	 * request synchronously instead, other -ve on error
+	 */
+	int (*submit)(struct udevice *dev, struct blk_request *req);
+
+	/**
+	 * poll() - check for completed requests
+	 *
+	 * Calls blk_request_done() for each request which has completed
+	 * since the last call. This must not wait for requests to complete.
+	 *
+	 * @dev:	Block device to check
+	 * @return number of requests completed, or -ve on error
+	 */
+	int (*poll)(struct udevice *dev);
 };
 
 #define blk_get_ops(dev)	((struct blk_ops *)(dev)->driver->ops)
@@ -314,6 +455,63 @@ long blk_write(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
  */
 long blk_erase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt);
 
+/**
+ * blk_submit() - Queue a block I/O request
+ *
+ * Starts the transfer described by @req. If the device driver supports
+ * queued requests this returns as soon as the request is queued, so that
+ * several requests can be in flight at once. Otherwise the transfer is carried
+ * out before returning. In either case the request is complete once its
+ * status is no longer -EINPROGRESS; use blk_poll() or blk_wait() to move it
+ * along.
+ *
+ * Requests bypass the block cache, so are best suited to large transfers.
+ *
+ * @dev: Device to use
+ * @req: Request to queue; all fields up to @sg_count must be set, as well
+ *	as @complete and @priv if needed
+ * Return: 0 if queued (or completed), -EBUSY if the device cannot accept any
+ * more requests until some have completed, other -ve on error
+ */
+int blk_submit(struct udevice *dev, struct blk_request *req);
+
+/**
+ * blk_poll() - Check for completed block I/O requests
+ *
+ * @dev: Device to check
+ * Return: number of requests which completed, or -ve on error
+ */
+int blk_poll(struct udevice *dev);
+
+/**
+ * blk_wait() - Wait for a block I/O request to complete
+ *
+ * @req: Request to wait for, which must have been submitted
+ * Return: status of the request: 0 if OK, -ve on error
+ */
+int blk_wait(struct blk_request *req);
+
+/**
+ * blk_request_done() - Mark a block I/O request as complete
+ *
+ * This is called by block device drivers when a request completes. It records
+ * the outcome and calls the request's completion function, if any.
+ *
+ * @req: Request which has completed
+ * @blkcnt: Number of blocks transferred
+ * @status: 0 if OK, -ve on error. If @blkcnt is short and @status is 0,
+ *	-EIO is recorded instead.
+ */
+void blk_request_done(struct blk_request *req, lbaint_t blkcnt, int status);
+
+/**
+ * blk_request_blkcnt() - Get the total number of blocks in a request
+ *
+ * @req: Request to check
+ * Return: total number of blocks in all segments of @req
+ */
+lbaint_t blk_request_blkcnt(const struct blk_request *req);
+
 /**
  * blk_find_device() - Find a block device
  *
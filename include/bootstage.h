@@ -331,6 +331,21 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name);
  */
 uint32_t bootstage_accum(enum bootstage_id id);
 
+/**
+ * bootstage_add_accum() - Add the time taken by an activity timed elsewhere
+ *
+ * This adds a new accumulated-time record, as bootstage_start() followed by
+ * bootstage_accum() would, for an activity whose start time and duration are
+ * already known.
+ *
+ * @name: Name of the activity, which must remain valid
+ * @start_us: Time at which the activity started
+ * @duration_us: Time taken by the activity
+ * Return: @duration_us
+ */
+uint32_t bootstage_add_accum(const char *name, ulong start_us,
+			     uint32_t duration_us);
+
 /* Print a report about boot time */
 void bootstage_report(void);
 
@@ -430,6 +445,12 @@ static inline uint32_t bootstage_accum(enum bootstage_id id)
 	return 0;
 }
 
+static inline uint32_t bootstage_add_accum(const char *name, ulong start_us,
+					   uint32_t duration_us)
+{
+	return duration_us;
+}
+
 static inline int bootstage_stash(void *base, int size)
 {
 	return 0;	/* Pretend to succeed */
@@ -185,13 +185,42 @@ int device_of_to_plat(struct udevice *dev);
  * device_probe() - Probe a device, activating it
  *
  * Activate a device (if not yet activated) so that it is ready for use.
- * All its parents are probed first.
+ * All its parents are probed first. If the device is still settling after
+ * device_probe_start(), this waits for it.
  *
  * @dev: Pointer to device to probe
  * Return: 0 if OK, -ve on error
  */
 int device_probe(struct udevice *dev);
 
+/**
+ * device_probe_start() - Start probing a device, without waiting for it
+ *
+ * This is the same as device_probe() except for devices whose driver has
+ * DM_FLAG_ASYNC_PROBE. If such a device is not ready once probe() returns, it
+ * is left to settle in the background and marked DM_FLAG_PROBE_PENDING.
+ * device_active() is false until it is finished off, by the next
+ * device_probe() of the device or by device_probe_wait_all(). If it fails
+ * then, it is left unprobed, so device_probe() tries again.
+ *
+ * @dev: Pointer to device to probe
+ * Return: 0 if OK or still settling, -ve on error
+ */
+int device_probe_start(struct udevice *dev);
+
+#if CONFIG_IS_ENABLED(DM_ASYNC_PROBE)
+/**
+ * device_probe_wait_all() - Finish probing all devices which are settling
+ *
+ * This polls the devices left settling by device_probe_start() and finishes
+ * probing each one as soon as it is ready, so that their settle times
+ * overlap. Devices which fail to settle are left unprobed.
+ */
+void device_probe_wait_all(void);
+#else
+static inline void device_probe_wait_all(void) {}
+#endif
+
 /**
  * device_remove() - Remove a device, de-activating it
  *
@@ -84,6 +84,15 @@ struct driver_info;
 /* Device must be probed after it was bound */
 #define DM_FLAG_PROBE_AFTER_BIND	(1 << 15)
 
+/* Probe after bind returned -EPROBE_DEFER and is to be retried */
+#define DM_FLAG_PROBE_DEFERRED		(1 << 16)
+
+/* Driver probes in two phases, see probe_complete() in struct driver */
+#define DM_FLAG_ASYNC_PROBE		(1 << 17)
+
+/* Device probe was started but probe_complete() has not yet returned */
+#define DM_FLAG_PROBE_PENDING		(1 << 18)
+
 /*
  * One or multiple of these flags are passed to device_remove() so that
  * a selective device removal as specified by the remove-stage and the
@@ -166,6 +175,17 @@ enum {
  * @dma_offset: Offset between the physical address space (CPU's) and the
  *		device's bus address space
  * @iommu: IOMMU device associated with this device
+ * @seq_hnode: Used by the uclass index to hash the device by sequence number
+ * @node_hnode: Used by the uclass index to hash the device by ofnode
+ * @phandle_hnode: Used by the uclass index to hash the device by phandle
+ * @bind_us: Time taken to bind the device, in microseconds, not counting
+ *	other devices bound meanwhile (CONFIG_DM_TIMING)
+ * @probe_start_us: Boot time at which the device last started probing, in
+ *	microseconds, or 0 if not timed (CONFIG_DM_TIMING)
+ * @probe_us: Time taken by the last probe, in microseconds, including any
+ *	other devices probed meanwhile, such as parents (CONFIG_DM_TIMING)
+ * @probe_self_us: Time taken by the last probe, in microseconds, not counting
+ *	other devices bound or probed meanwhile (CONFIG_DM_TIMING)
  */
 struct udevice {
 	const struct driver *driver;
@@ -198,6 +218,17 @@ struct udevice {
 #if CONFIG_IS_ENABLED(IOMMU)
 	struct udevice *iommu;
 #endif
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct hlist_node seq_hnode;
+	struct hlist_node node_hnode;
+	struct hlist_node phandle_hnode;
+#endif
+#if CONFIG_IS_ENABLED(DM_TIMING)
+	ulong bind_us;
+	ulong probe_start_us;
+	ulong probe_us;
+	ulong probe_self_us;
+#endif
 };
 
 static inline int dm_udevice_size(void)
@@ -266,8 +297,13 @@ static inline __attribute_const__ ofnode dev_ofnode(const struct udevice *dev)
 #endif
 }
 
-/* Returns non-zero if the device is active (probed and not removed) */
-#define device_active(dev)	(dev_get_flags(dev) & DM_FLAG_ACTIVATED)
+/*
+ * Returns non-zero if the device is active (probed and not removed). A device
+ * still settling after device_probe_start() is not active yet.
+ */
+#define device_active(dev)	((dev_get_flags(dev) & \
+				  (DM_FLAG_ACTIVATED | DM_FLAG_PROBE_PENDING)) == \
+				 DM_FLAG_ACTIVATED)
 
 #if CONFIG_IS_ENABLED(DM_DMA)
 #define dev_set_dma_offset(_dev, _offset)	_dev->dma_offset = _offset
@@ -370,6 +406,11 @@ struct udevice_id {
  * @flags: driver flags - see `DM_FLAGS_...`
  * @acpi_ops: Advanced Configuration and Power Interface (ACPI) operations,
  * allowing the device to add things to the ACPI tables passed to Linux
+ * @probe_complete: Called after @probe for drivers with DM_FLAG_ASYNC_PROBE,
+ * where @probe only starts the device. Returns -EINPROGRESS while the device
+ * is still settling, 0 once it is ready, or another error if it failed, in
+ * which case it must undo what @probe did. This is called until it stops
+ * returning -EINPROGRESS, so it must not wait itself.
  */
 struct driver {
 	char *name;
@@ -392,8 +433,18 @@ struct driver {
 #if CONFIG_IS_ENABLED(ACPIGEN)
 	struct acpi_ops *acpi_ops;
 #endif
+#if CONFIG_IS_ENABLED(DM_ASYNC_PROBE)
+	int (*probe_complete)(struct udevice *dev);
+#endif
 };
 
+/* Allow the second probe phase to be optional */
+#if CONFIG_IS_ENABLED(DM_ASYNC_PROBE)
+#define DM_PROBE_COMPLETE_PTR(_fn)	.probe_complete	= _fn,
+#else
+#define DM_PROBE_COMPLETE_PTR(_fn)
+#endif
+
 /**
  * U_BOOT_DRIVER() - Declare a new U-Boot driver
  * @__name: name of the driver
@@ -958,6 +1009,41 @@ int device_set_name(struct udevice *dev, const char *name);
  */
 void device_set_name_alloced(struct udevice *dev);
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+/**
+ * device_set_ofnode() - change the device tree node of a bound device
+ *
+ * Use this rather than dev_set_ofnode() once the device is bound, so that
+ * lookups by ofnode and phandle find the device under its new node.
+ *
+ * @dev:	Device to update
+ * @node:	New node for the device
+ */
+void device_set_ofnode(struct udevice *dev, ofnode node);
+
+/**
+ * device_set_seq() - change the sequence number of a bound device
+ *
+ * This is for uclasses which use DM_UC_FLAG_NO_AUTO_SEQ and number their
+ * devices after bind. Lookups by sequence number then find the device under
+ * its new number.
+ *
+ * @dev:	Device to update
+ * @seq:	New sequence number, or -1 for none
+ */
+void device_set_seq(struct udevice *dev, int seq);
+#else
+static inline void device_set_ofnode(struct udevice *dev, ofnode node)
+{
+	dev_set_ofnode(dev, node);
+}
+
+static inline void device_set_seq(struct udevice *dev, int seq)
+{
+	dev->seq_ = seq;
+}
+#endif
+
 /**
  * device_is_compatible() - check if the device is compatible with the compat
  *
@@ -511,6 +511,19 @@ int of_count_phandle_with_args(const struct device_node *np,
 			       const char *list_name, const char *cells_name,
 			       int cells_count);
 
+/**
+ * of_index_build() - Build the lookup index for a live tree
+ *
+ * This indexes all nodes in the tree by phandle and full path, and for the
+ * control FDT also by alias, so that of_find_node_by_phandle() and
+ * of_find_node_opts_by_path() do not need to walk the tree. Any previous
+ * index is dropped. Only available with CONFIG_OF_LOOKUP_INDEX
+ *
+ * @root: Root node of the tree to index
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+int of_index_build(struct device_node *root);
+
 /**
  * of_alias_scan() - Scan all properties of the 'aliases' node
  *
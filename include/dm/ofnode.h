@@ -996,6 +996,54 @@ int ofnode_decode_panel_timing(ofnode node,
  */
 const void *ofnode_get_property(ofnode node, const char *propname, int *lenp);
 
+/**
+ * struct ofnode_prop_count - property lookups made on one node
+ *
+ * @node: Offset of the node in the control FDT
+ * @lookups: Number of properties looked up in the node, 0 if unused
+ * @hits: Number of those lookups which were found in the property cache
+ */
+struct ofnode_prop_count {
+	int node;
+	uint lookups;
+	uint hits;
+};
+
+/**
+ * struct ofnode_prop_stats - statistics of the flat-tree property cache
+ *
+ * @lookups: Total number of property lookups in the control FDT
+ * @hits: Number of those lookups which were found in the property cache
+ * @untracked: Number of lookups on nodes which are not in @count
+ * @count: Lookups made on each node. Entries with no lookups are unused
+ * @num_counts: Number of entries in @count
+ */
+struct ofnode_prop_stats {
+	uint lookups;
+	uint hits;
+	uint untracked;
+	const struct ofnode_prop_count *count;
+	int num_counts;
+};
+
+#if CONFIG_IS_ENABLED(OFNODE_PROP_CACHE) && CONFIG_IS_ENABLED(DM_STATS)
+/**
+ * ofnode_get_prop_stats() - get statistics of the flat-tree property cache
+ *
+ * The per-node counts are reset when the structure of the control FDT
+ * changes, since node offsets are no longer valid then.
+ *
+ * @stats: Returns the statistics
+ * Return: 0 if OK, -ENOENT if no property has been read yet
+ */
+int ofnode_get_prop_stats(struct ofnode_prop_stats *stats);
+#else
+static inline int ofnode_get_prop_stats(struct ofnode_prop_stats *stats)
+{
+	return -ENOSYS;
+}
+#endif
+
 /**
  * ofnode_first_property()- get the reference of the first property
  *
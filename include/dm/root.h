@@ -123,6 +123,20 @@ int dm_extended_scan(bool pre_reloc_only);
  */
 int dm_scan_other(bool pre_reloc_only);
 
+/**
+ * dm_autoprobe() - Probe devices which are marked for probing after bind
+ *
+ * This probes each device with DM_FLAG_PROBE_AFTER_BIND, parents before
+ * children. With CONFIG_DM_PROBE_DEFER, devices which return -EPROBE_DEFER
+ * are retried after the others, along with their children, for as long as
+ * each retry gets another deferred device probed.
+ *
+ * @pre_reloc_only: If true, probe only nodes with special devicetree
+ * properties, or drivers with the DM_FLAG_PRE_RELOC flag
+ * Return: 0 if OK, -ve on error
+ */
+int dm_autoprobe(bool pre_reloc_only);
+
 /**
  * dm_init_and_scan() - Initialise Driver Model structures and scan for devices
  *
@@ -186,4 +200,20 @@ void dm_get_stats(int *device_countp, int *uclass_countp);
  */
 void dm_get_mem(struct dm_stats *stats);
 
+#if CONFIG_IS_ENABLED(DM_TIMING)
+/**
+ * dm_timing_bootstage() - Add the slowest device probes to bootstage
+ *
+ * This adds an accumulated-time bootstage record for each of the
+ * CONFIG_DM_TIMING_BOOTSTAGE devices which took longest to probe, not
+ * counting other devices probed meanwhile, so that they are included in the
+ * bootstage report and the information passed to the OS.
+ */
+void dm_timing_bootstage(void);
+#else
+static inline void dm_timing_bootstage(void)
+{
+}
+#endif
+
 #endif
@@ -259,6 +259,32 @@ int uclass_find_device_by_phandle(enum uclass_id id, struct udevice *parent,
  */
 int uclass_bind_device(struct udevice *dev);
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+/**
+ * dm_index_init() - Set up an empty uclass and device index
+ *
+ * This is called by dm_init() before any device is bound. Before relocation
+ * it does nothing, so lookups walk the lists as usual.
+ *
+ * Return: 0 on success, -ENOMEM if out of memory
+ */
+int dm_index_init(void);
+
+/**
+ * uclass_reindex_device() - Update the index after a device's keys changed
+ *
+ * The index is updated when a device is bound and unbound. This is called
+ * by device_set_ofnode() and device_set_seq() when the ofnode or sequence
+ * number of a bound device is changed afterwards.
+ *
+ * @dev:	Pointer to the device
+ */
+void uclass_reindex_device(struct udevice *dev);
+#else
+static inline int dm_index_init(void) { return 0; }
+static inline void uclass_reindex_device(struct udevice *dev) {}
+#endif
+
 #if CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)
 /**
  * uclass_pre_unbind_device() - Prepare to deassociate device with a uclass
@@ -439,7 +439,8 @@ int uclass_first_device_drvdata(enum uclass_id id, ulong driver_data,
  * uclass_probe_all() - Probe all devices based on an uclass ID
  *
  * This function probes all devices associated with a uclass by
- * looking for its ID.
+ * looking for its ID. With CONFIG_DM_ASYNC_PROBE, devices which probe
+ * asynchronously are all started before any of them is waited for.
  *
  * @id: uclass ID to look up
  * Return: 0 if OK, other -ve on error
@@ -61,6 +61,26 @@ void dm_dump_static_driver_info(void);
  */
 void dm_dump_mem(struct dm_stats *stats);
 
+/**
+ * dm_dump_prop_stats() - Dump property lookups made on each node
+ *
+ * This shows the counts collected by the flat-tree property cache, see
+ * CONFIG_OFNODE_PROP_CACHE
+ */
+void dm_dump_prop_stats(void);
+
+/**
+ * dm_dump_timing() - Dump the time taken to probe each device
+ *
+ * This needs CONFIG_DM_TIMING. Only devices in the current driver model tree
+ * are shown, so devices probed before relocation are not included.
+ *
+ * @sort: true to sort by the time taken by each device itself, slowest first,
+ *	false to show devices in the order they were probed, with those probed
+ *	while another device was probing indented below it
+ */
+void dm_dump_timing(bool sort);
+
 #if CONFIG_IS_ENABLED(OF_PLATDATA_INST) && CONFIG_IS_ENABLED(READ_ONLY)
 void *dm_priv_to_rw(void *priv);
 #else
@@ -685,6 +685,19 @@ int fdtdec_get_chosen_node(const void *blob, const char *name);
  */
 const char *fdtdec_get_compatible(enum fdt_compat_id id);
 
+/**
+ * fdtdec_node_offset_by_phandle() - Find the node with a given phandle
+ *
+ * This is fdt_node_offset_by_phandle(), but for the control FDT it uses a
+ * lookup table if CONFIG_OF_LOOKUP_INDEX is enabled, instead of scanning the
+ * whole tree.
+ *
+ * @blob: FDT blob
+ * @phandle: phandle to look for
+ * Return: offset of the node if found, -ve FDT_ERR_... error code on error
+ */
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle);
+
 /* Look up a phandle and follow it to its node. Then return the offset
  * of that node.
  *
@@ -23,6 +23,9 @@ int gzip_parse_header(const unsigned char *src, unsigned long len);
 /**
  * gunzip() - Decompress gzipped data
  *
+ * If there are several gzip members one after the other, they are all
+ * decompressed, with their output following on in @dst.
+ *
  * @dst: Destination for uncompressed data
  * @dstlen: Size of destination buffer
  * @src: Source data to decompress
@@ -120,6 +120,66 @@ int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 int hash_block(const char *algo_name, const void *data, unsigned int len,
 	       uint8_t *output, int *output_size);
 
+#if CONFIG_IS_ENABLED(HASH_LOAD)
+/**
+ * hash_load_start() - Start hashing a file which is about to be loaded
+ *
+ * If the 'loadhash' environment variable names a hash algorithm, this starts
+ * hashing the file. The 'filehash' variable is cleared in any case.
+ *
+ * @addr: Address the file is being loaded to
+ * Return: 0 if OK (including when no hash is wanted), -ve on error
+ */
+int hash_load_start(ulong addr);
+
+/**
+ * hash_load_update() - Hash part of a file as it is stored
+ *
+ * Parts can be passed in any order and more than once; those which do not
+ * follow on from the data already hashed are hashed from memory by
+ * hash_load_finish() instead.
+ *
+ * @offset: Offset of the data from the start of the file
+ * @buf: Data, which need not be at its final location
+ * @len: Length of data in bytes
+ */
+void hash_load_update(ulong offset, const void *buf, ulong len);
+
+/**
+ * hash_load_finish() - Finish hashing a file once it is loaded
+ *
+ * This hashes any part of the file not already hashed and sets the 'filehash'
+ * environment variable to the digest, as a hex string.
+ *
+ * @size: Size of the file in bytes
+ * Return: 0 if OK, -ve on error
+ */
+int hash_load_finish(ulong size);
+
+/**
+ * hash_load_abort() - Stop hashing a file which failed to load
+ */
+void hash_load_abort(void);
+#else
+static inline int hash_load_start(ulong addr)
+{
+	return 0;
+}
+
+static inline void hash_load_update(ulong offset, const void *buf, ulong len)
+{
+}
+
+static inline int hash_load_finish(ulong size)
+{
+	return 0;
+}
+
+static inline void hash_load_abort(void)
+{
+}
+#endif
+
 #endif /* !USE_HOSTCC */
 
 /**
@@ -1383,6 +1383,60 @@ int fit_check_ramdisk(const void *fit, int os_noffset,
 int calculate_hash(const void *data, int data_len, const char *algo,
 			uint8_t *value, int *value_len);
 
+/**
+ * fit_digest_lookup() - Look up a digest already calculated for image data
+ *
+ * While fit_image_verify_with_data() is running, the digest of the image data
+ * is kept for each hash algorithm used, so that hash and signature nodes
+ * using the same algorithm do not hash the data again.
+ *
+ * @algo: Name of the hash algorithm, e.g. "sha256"
+ * @data: Image data
+ * @size: Size of image data in bytes
+ * @value: Returns the digest; must hold FIT_MAX_HASH_LEN bytes
+ * @value_lenp: Returns the length of the digest in bytes
+ * Return: true if found, false if the digest must be calculated
+ */
+bool fit_digest_lookup(const char *algo, const void *data, size_t size,
+		       uint8_t *value, int *value_lenp);
+
+/**
+ * fit_digest_save() - Save the digest calculated for image data
+ *
+ * This does nothing unless @data is the image being verified by
+ * fit_image_verify_with_data(). See fit_digest_lookup().
+ *
+ * @algo: Name of the hash algorithm, e.g. "sha256"; this must remain valid
+ *	until verification is complete
+ * @data: Image data
+ * @size: Size of image data in bytes
+ * @value: Digest
+ * @value_len: Length of the digest in bytes
+ */
+void fit_digest_save(const char *algo, const void *data, size_t size,
+		     const uint8_t *value, int value_len);
+
+/**
+ * fit_digest_calc_count() - Get the number of image digests calculated
+ *
+ * This counts the calls to fit_digest_save(), i.e. the number of times image
+ * data has been hashed rather than found by fit_digest_lookup(). It is
+ * intended for tests.
+ *
+ * Return: number of digests calculated so far
+ */
+int fit_digest_calc_count(void);
+
+/**
+ * fit_digest_hit_count() - Get the number of image digests reused
+ *
+ * This counts the digests found by fit_digest_lookup(), so that the data did
+ * not need to be hashed again. It is intended for tests.
+ *
+ * Return: number of digests reused so far
+ */
+int fit_digest_hit_count(void);
+
 /*
  * At present we only support signing on the host, and verification on the
  * device
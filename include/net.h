@@ -41,6 +41,9 @@ struct udevice;
 /* Number of packets processed together */
 #define ETH_PACKETS_BATCH_RECV	32
 
+/* Number of full batches net_loop() processes back to back */
+#define NET_RX_BURSTS		8
+
 /* ARP hardware address length */
 #define ARP_HLEN 6
 /*
@@ -182,6 +185,52 @@ struct eth_ops {
 
 #define eth_get_ops(dev) ((struct eth_ops *)(dev)->driver->ops)
 
+/**
+ * struct eth_stats - Ethernet device statistics
+ *
+ * @rx_packets: Frames handed to the network stack
+ * @rx_bytes: Bytes handed to the network stack
+ * @rx_errors: Errors returned by the recv() method
+ * @rx_dropped: Frames the driver discarded, e.g. malformed or without buffer
+ * @rx_overruns: Frames lost because the receive ring was full
+ * @rx_polls: Calls to eth_rx() which received at least one frame
+ * @rx_full_batches: Calls to eth_rx() which used up the whole batch, so the
+ *		     ring may still have held frames
+ * @tx_packets: Frames sent
+ * @tx_errors: Errors returned by the send() method
+ */
+struct eth_stats {
+	ulong rx_packets;
+	ulong rx_bytes;
+	ulong rx_errors;
+	ulong rx_dropped;
+	ulong rx_overruns;
+	ulong rx_polls;
+	ulong rx_full_batches;
+	ulong tx_packets;
+	ulong tx_errors;
+};
+
+/**
+ * eth_get_stats() - get the statistics of an Ethernet device
+ *
+ * @dev: Ethernet device
+ * Return: statistics, or NULL if the device is not probed
+ */
+const struct eth_stats *eth_get_stats(const struct udevice *dev);
+
+/**
+ * eth_count_rx_drop() - account for received frames lost by a driver
+ *
+ * Drivers call this when they learn about frames that never reached the
+ * network stack, typically from the controller's missed frame counters.
+ *
+ * @dev: Ethernet device
+ * @dropped: Frames discarded by the driver
+ * @overruns: Frames lost because the receive ring was full
+ */
+void eth_count_rx_drop(struct udevice *dev, uint dropped, uint overruns);
+
 struct udevice *eth_get_dev(void); /* get the current device */
 /*
  * The devname can be either an exact name given by the driver or device tree
@@ -244,7 +293,7 @@ int eth_send(void *packet, int length);	   /* Send a packet */
 int eth_receive(void *packet, int length); /* Receive a packet*/
 extern void (*push_packet)(void *packet, int length);
 #endif
-int eth_rx(void);			/* Check for received packets */
+int eth_rx(void);			/* Process received packets */
 void eth_halt(void);			/* stop SCC */
 const char *eth_get_name(void);		/* get name of current device */
 int eth_mcast_join(struct in_addr mcast_addr, int join);
@@ -68,8 +68,8 @@ struct ip_tcp_hdr {
  * TCP header options, Seq, MSS, and SACK
  */
 
-#define TCP_SACK 32			/* Number of packets analyzed   */
-					/* on leading edge of stream    */
+#define TCP_SACK 32			/* Number of out-of-order ranges */
+					/* tracked beyond the ACK edge   */
 
 #define TCP_O_END	0x00		/* End of option list		*/
 #define TCP_1_NOP	0x01		/* Single padding NOP		*/
@@ -87,6 +87,15 @@ struct ip_tcp_hdr {
 #define TCP_OPT_LEN_A	0x0a		/* Timestamp Length		*/
 #define TCP_MSS		1460		/* Max segment size		*/
 #define TCP_SCALE	0x01		/* Scale			*/
+#define TCP_MAX_SCALE	14		/* Largest shift, RFC 7323	*/
+#define TCP_RCV_WND	(CONFIG_PROT_TCP_WINDOW * TCP_MSS)
+
+/*
+ * Delayed ACKs: in-order data is acknowledged every TCP_ACK_SEGS full
+ * segments, or once no more data has arrived for TCP_DELACK_TIMEOUT ms.
+ */
+#define TCP_ACK_SEGS		2
+#define TCP_DELACK_TIMEOUT	20UL
 
 /**
  * struct tcp_mss - TCP option structure for MSS (Max segment size)
@@ -295,5 +304,15 @@ void tcp_set_tcp_handler(rxhand_tcp *f);
 
 void rxhand_tcp_f(union tcp_build_pkt *b, unsigned int len);
 
+/**
+ * tcp_ack_due() - check whether received data must be acknowledged now
+ *
+ * Out-of-order, duplicate and short segments are acknowledged at once,
+ * in-order data only every TCP_ACK_SEGS segments.
+ *
+ * Return: true if an ACK should be sent now, false if it may be delayed
+ */
+bool tcp_ack_due(void);
+
 u16 tcp_set_pseudo_header(uchar *pkt, struct in_addr src, struct in_addr dest,
 			  int tcp_len, int pkt_len);
@@ -18,6 +18,32 @@ typedef struct {
 
 extern const uint8_t sha512_der_prefix[];
 
+/**
+ * sha512_process() - Hash whole blocks of data
+ *
+ * This is a weak function, which architectures can override with an
+ * accelerated version.
+ *
+ * @ctx: Context to update
+ * @data: Data to hash
+ * @blocks: Number of SHA512_BLOCK_SIZE blocks at @data
+ */
+void sha512_process(sha512_context *ctx, const unsigned char *data,
+		    unsigned int blocks);
+
+/**
+ * sha512_process_generic() - Hash whole blocks of data in C
+ *
+ * This is the portable implementation of sha512_process(), for use when
+ * acceleration is not available.
+ *
+ * @ctx: Context to update
+ * @data: Data to hash
+ * @blocks: Number of SHA512_BLOCK_SIZE blocks at @data
+ */
+void sha512_process_generic(sha512_context *ctx, const unsigned char *data,
+			    unsigned int blocks);
+
 void sha512_starts(sha512_context * ctx);
 void sha512_update(sha512_context *ctx, const uint8_t *input, uint32_t length);
 void sha512_finish(sha512_context * ctx, uint8_t digest[SHA512_SUM_LEN]);
@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Decompress a file while it is being loaded
+ */
+
+#ifndef __UNZIP_LOAD_H
+#define __UNZIP_LOAD_H
+
+#if CONFIG_IS_ENABLED(UNZIP_LOAD)
+/**
+ * unzip_load_start() - Prepare to decompress a file which is about to be loaded
+ *
+ * If the 'unzipaddr' environment variable is set, this arranges for the file
+ * to be decompressed to that address as it arrives. The 'unzipsize' variable
+ * is cleared in any case.
+ *
+ * @addr: Address the (compressed) file is being loaded to
+ * Return: 0 if OK (including when no decompression is wanted), -ve on error
+ */
+int unzip_load_start(ulong addr);
+
+/**
+ * unzip_load_update() - Record that part of the file has been loaded
+ *
+ * This must be called after part of the file has been written to memory. It
+ * does not decompress anything, so that the caller can reply to the sender
+ * straight away. Parts which do not follow on from the data already loaded
+ * are left until a later call, or until unzip_load_finish().
+ *
+ * @offset: Offset of the data from the start of the file
+ * @len: Length of data in bytes
+ */
+void unzip_load_update(ulong offset, ulong len);
+
+/**
+ * unzip_load_poll() - Decompress some of the data loaded so far
+ *
+ * This should be called while waiting for more of the file to arrive. It
+ * decompresses a limited amount each time, so that incoming packets are not
+ * held up for long.
+ *
+ * Files which are not compressed in a supported format are ignored.
+ */
+void unzip_load_poll(void);
+
+/**
+ * unzip_load_finish() - Finish decompressing a file once it is loaded
+ *
+ * This decompresses any part of the file not already handled and sets the
+ * 'unzipsize' environment variable to the size of the decompressed data.
+ *
+ * @size: Size of the (compressed) file in bytes
+ * Return: 0 if OK, -ve on error
+ */
+int unzip_load_finish(ulong size);
+
+/**
+ * unzip_load_abort() - Stop decompressing a file which failed to load
+ */
+void unzip_load_abort(void);
+#else
+static inline int unzip_load_start(ulong addr)
+{
+	return 0;
+}
+
+static inline void unzip_load_update(ulong offset, ulong len)
+{
+}
+
+static inline void unzip_load_poll(void)
+{
+}
+
+static inline int unzip_load_finish(ulong size)
+{
+	return 0;
+}
+
+static inline void unzip_load_abort(void)
+{
+}
+#endif
+
+#endif
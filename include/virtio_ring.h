@@ -63,6 +63,10 @@ struct vring_desc_shadow {
 	u16 next;
 	/* Metadata about the descriptor. */
 	bool chain_head;
+	/* Indirect table owned by this chain head */
+	struct vring_desc *indir;
+	/* Caller's first buffer, not a bounce buffer, for virtqueue_get_buf() */
+	void *data;
 };
 
 struct vring_avail {
@@ -103,6 +107,7 @@ struct vring {
  * @vring: actual memory layout for this queue
  * @vring_desc_shadow: guest-only copy of descriptors
  * @event: host publishes avail event idx
+ * @indirect: multi-buffer chains may be placed in an indirect table
  * @free_head: head of free buffer list
  * @num_added: number we've added since last sync
  * @last_used_idx: last used index we've seen
@@ -117,6 +122,7 @@ struct virtqueue {
 	struct vring vring;
 	struct vring_desc_shadow *vring_desc_shadow;
 	bool event;
+	bool indirect;
 	unsigned int free_head;
 	unsigned int num_added;
 	u16 last_used_idx;
@@ -187,6 +193,10 @@ struct virtio_sg;
  * @in_sgs:	the number of scatterlists which are writable
  *		(after readable ones)
  *
+ * If VIRTIO_RING_F_INDIRECT_DESC was negotiated, a chain of more than one
+ * buffer is described by a single ring descriptor pointing to an indirect
+ * table, so that many requests can be queued at once.
+ *
  * Caller must ensure we don't call this with other virtqueue operations
  * at the same time (except where noted).
  *
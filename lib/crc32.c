@@ -14,6 +14,9 @@
 #else
 #include <common.h>
 #include <efi_loader.h>
+#ifdef CONFIG_ARM64_CRC32
+#include <asm/system.h>
+#endif
 #endif
 #include <compiler.h>
 #include <u-boot/crc.h>
@@ -179,20 +182,51 @@ const uint32_t * ZEXPORT get_crc_table()
 
 /* ========================================================================= */
 
+#ifdef CONFIG_ARM64_CRC32
+/*
+ * Whether the CRC32 instructions are there, -1 until checked. Reading the ID
+ * register may trap to a hypervisor, so only do that once. This is not in
+ * gd, since it is also used by the EFI runtime.
+ */
+static int __efi_runtime_data crc32_hw = -1;
+
+static int __efi_runtime crc32_hw_present(void)
+{
+	if (crc32_hw < 0)
+		crc32_hw = cpu_has_crc32() ? 1 : 0;
+
+	return crc32_hw;
+}
+
+/* Use the CRC32 instructions, eight bytes at a time once buf is aligned */
+static uint32_t __efi_runtime crc32_arm64(uint32_t crc, const Bytef *buf,
+					  uInt len)
+{
+	for (; len && ((ulong)buf & 7); len--)
+		crc = __builtin_aarch64_crc32b(crc, *buf++);
+	for (; len >= 8; len -= 8, buf += 8)
+		crc = __builtin_aarch64_crc32x(crc,
+					       le64_to_cpu(*(uint64_t *)buf));
+	while (len--)
+		crc = __builtin_aarch64_crc32b(crc, *buf++);
+
+	return crc;
+}
+#endif
+
 /* No ones complement version. JFFS2 (and other things ?)
  * don't use ones compliment in their CRC calculations.
  */
 uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 {
-#ifdef CONFIG_ARM64_CRC32
-    crc = cpu_to_le32(crc);
-    while (len--)
-        crc = __builtin_aarch64_crc32b(crc, *buf++);
-    return le32_to_cpu(crc);
-#else
     const uint32_t *tab = crc_table;
     const uint32_t *b =(const uint32_t *)buf;
     size_t rem_len;
+#ifdef CONFIG_ARM64_CRC32
+    /* the instructions are optional before ARMv8.1 */
+    if (crc32_hw_present())
+        return crc32_arm64(crc, buf, len);
+#endif
 #ifdef CONFIG_DYNAMIC_CRC_TABLE
     if (crc_table_empty)
       make_crc_table();
@@ -227,7 +261,6 @@ uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
     }
 
     return le32_to_cpu(crc);
-#endif
 }
 #undef DO_CRC
 
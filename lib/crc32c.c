@@ -12,10 +12,93 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <asm/global_data.h>
+#include <u-boot/crc.h>
+#if defined(CONFIG_ARM64_CRC32)
+#include <asm/system.h>
+#elif defined(CONFIG_X86)
+#include <asm/cpu.h>
+#endif
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Bit-reflected Castagnoli polynomial, which the CRC32C instructions use */
+#define CRC32C_POLY_LE	0x82f63b78
+
+#if defined(CONFIG_ARM64_CRC32) || defined(CONFIG_X86)
+/*
+ * Whether the CRC32C instructions are there, -1 until checked. Reading the ID
+ * register or CPUID may trap to a hypervisor, so only do that once. The
+ * result is kept only after relocation, since before then this may be in
+ * read-only memory.
+ */
+static int crc32c_has_hw = -1;
+
+static bool crc32c_hw_present(void)
+{
+	int present;
+
+	if (crc32c_has_hw >= 0)
+		return crc32c_has_hw;
+#if defined(CONFIG_ARM64_CRC32)
+	present = cpu_has_crc32() ? 1 : 0;
+#else
+	present = cpu_has_sse4_2() ? 1 : 0;
+#endif
+	if (gd->flags & GD_FLG_RELOC)
+		crc32c_has_hw = present;
+
+	return present;
+}
+#endif
+
+#if defined(CONFIG_ARM64_CRC32)
+static uint32_t crc32c_hw(uint32_t crc, const u8 *data, int length)
+{
+	for (; length && ((ulong)data & 7); length--)
+		crc = __builtin_aarch64_crc32cb(crc, *data++);
+	for (; length >= 8; length -= 8, data += 8)
+		crc = __builtin_aarch64_crc32cx(crc,
+						le64_to_cpu(*(u64 *)data));
+	while (length--)
+		crc = __builtin_aarch64_crc32cb(crc, *data++);
+
+	return crc;
+}
+#elif defined(CONFIG_X86)
+static uint32_t crc32c_hw(uint32_t crc, const u8 *data, int length)
+{
+	for (; length && ((ulong)data & 3); length--)
+		asm ("crc32b %1, %0" : "+r" (crc) : "rm" (*data++));
+	for (; length >= 4; length -= 4, data += 4)
+		asm ("crc32l %1, %0" : "+r" (crc) : "rm" (*(u32 *)data));
+	while (length--)
+		asm ("crc32b %1, %0" : "+r" (crc) : "rm" (*data++));
+
+	return crc;
+}
+#else
+static bool crc32c_hw_present(void)
+{
+	return false;
+}
+
+static uint32_t crc32c_hw(uint32_t crc, const u8 *data, int length)
+{
+	return crc;
+}
+#endif
 
 uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
 		    uint32_t *crc32c_table)
 {
+	/*
+	 * Entry 128 of the table is the polynomial itself, so this checks
+	 * that the caller wants CRC32C and not some other CRC
+	 */
+	if (crc32c_table[128] == CRC32C_POLY_LE && crc32c_hw_present())
+		return crc32c_hw(crc, (const u8 *)data, length);
+
 	while (length--)
 		crc = crc32c_table[(u8)(crc ^ *data++)] ^ (crc >> 8);
 
@@ -32,6 +32,7 @@
 #include <linux/ctype.h>
 #include <linux/lzo.h>
 #include <linux/ioport.h>
+#include <linux/log2.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -632,6 +633,107 @@ int fdtdec_check_fdt(void)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(OF_LOOKUP_INDEX)
+/**
+ * struct fdtdec_phandle_index - Phandle lookup table for the control FDT
+ *
+ * The table uses open addressing with linear probing and has at least twice
+ * as many slots as entries. Node offsets change when the tree is edited, so
+ * the table is only used while the structure block keeps its size, and each
+ * hit is checked against the node's own phandle.
+ *
+ * @blob: Device tree the table was built from
+ * @struct_size: Size of the structure block of @blob at that time
+ * @mask: Number of slots minus one
+ * @slot: Slots, each with a phandle (0 if empty) and the offset of its node
+ */
+struct fdtdec_phandle_index {
+	const void *blob;
+	uint struct_size;
+	uint mask;
+	struct {
+		u32 phandle;
+		int offset;
+	} slot[];
+};
+
+static struct fdtdec_phandle_index *fdtdec_phandle_index(const void *blob)
+{
+	struct fdtdec_phandle_index *idx = gd->fdt_phandle_index;
+	uint count, size, i;
+	int offset;
+	u32 phandle;
+
+	if (idx && idx->blob == blob &&
+	    idx->struct_size == fdt_size_dt_struct(blob))
+		return idx;
+	free(idx);
+	gd->fdt_phandle_index = NULL;
+	if (fdt_version(blob) < 17)
+		return NULL;
+
+	count = 0;
+	for (offset = fdt_next_node(blob, -1, NULL); offset >= 0;
+	     offset = fdt_next_node(blob, offset, NULL)) {
+		if (fdt_get_phandle(blob, offset))
+			count++;
+	}
+	size = roundup_pow_of_two(2 * count + 2);
+	idx = calloc(1, sizeof(*idx) + size * sizeof(idx->slot[0]));
+	if (!idx)
+		return NULL;
+	idx->blob = blob;
+	idx->struct_size = fdt_size_dt_struct(blob);
+	idx->mask = size - 1;
+
+	for (offset = fdt_next_node(blob, -1, NULL); offset >= 0;
+	     offset = fdt_next_node(blob, offset, NULL)) {
+		phandle = fdt_get_phandle(blob, offset);
+		if (!phandle)
+			continue;
+
+		/* Keep the first node, which is what libfdt would find */
+		for (i = phandle & idx->mask; idx->slot[i].phandle &&
+		     idx->slot[i].phandle != phandle; i = (i + 1) & idx->mask)
+			;
+		if (!idx->slot[i].phandle) {
+			idx->slot[i].phandle = phandle;
+			idx->slot[i].offset = offset;
+		}
+	}
+	gd->fdt_phandle_index = idx;
+
+	return idx;
+}
+#endif
+
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle)
+{
+#if CONFIG_IS_ENABLED(OF_LOOKUP_INDEX)
+	struct fdtdec_phandle_index *idx = NULL;
+	int offset;
+	uint i;
+
+	/* Leave the pre-relocation malloc() pool alone */
+	if (blob == gd->fdt_blob && (gd->flags & GD_FLG_RELOC) &&
+	    phandle && phandle != ~0U)
+		idx = fdtdec_phandle_index(blob);
+	if (idx) {
+		for (i = phandle & idx->mask; idx->slot[i].phandle;
+		     i = (i + 1) & idx->mask) {
+			if (idx->slot[i].phandle != phandle)
+				continue;
+			offset = idx->slot[i].offset;
+			if (fdt_get_phandle(blob, offset) == phandle)
+				return offset;
+			break;
+		}
+	}
+#endif
+
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+
 int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 {
 	const u32 *phandle;
@@ -642,7 +744,7 @@ int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
-	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
+	lookup = fdtdec_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
 	return lookup;
 }
 
@@ -773,8 +875,8 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 			 * below.
 			 */
 			if (cells_name || cur_index == index) {
-				node = fdt_node_offset_by_phandle(blob,
-								  phandle);
+				node = fdtdec_node_offset_by_phandle(blob,
+								     phandle);
 				if (node < 0) {
 					debug("%s: could not find phandle\n",
 					      fdt_get_name(blob, src_node,
@@ -1496,7 +1598,7 @@ int fdtdec_get_carveout(const void *blob, const char *node,
 
 	phandle = fdt32_to_cpu(prop[index]);
 
-	offset = fdt_node_offset_by_phandle(blob, phandle);
+	offset = fdtdec_node_offset_by_phandle(blob, phandle);
 	if (offset < 0) {
 		debug("failed to find node for phandle %u\n", phandle);
 		return offset;
@@ -17,8 +17,8 @@
 #include <watchdog.h>
 #include <u-boot/zlib.h>
 
-#define HEADER0			'\x1f'
-#define HEADER1			'\x8b'
+#define HEADER0			0x1f
+#define HEADER1			0x8b
 #define	ZALLOC_ALIGNMENT	16
 #define HEAD_CRC		2
 #define EXTRA_FIELD		4
@@ -72,16 +72,6 @@ int gzip_parse_header(const unsigned char *src, unsigned long len)
 	return i;
 }
 
-int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
-{
-	int offset = gzip_parse_header(src, *lenp);
-
-	if (offset < 0)
-		return offset;
-
-	return zunzip(dst, dstlen, src, lenp, 1, offset);
-}
-
 #ifdef CONFIG_CMD_UNZIP
 __weak
 void gzwrite_progress_init(ulong expectedsize)
@@ -272,11 +262,18 @@ out:
 }
 #endif
 
-/*
- * Uncompress blocks compressed with zlib without headers
+/**
+ * zunzip_stream() - Uncompress a single deflate stream
+ *
+ * This is zunzip() but also returns the amount of input used, so that the
+ * caller can find what follows the stream.
+ *
+ * @inlenp: Returns the offset of the first byte in @src after the compressed
+ *	data
  */
-int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
-						int stoponerr, int offset)
+static int zunzip_stream(void *dst, int dstlen, unsigned char *src,
+			 unsigned long *lenp, int stoponerr, int offset,
+			 unsigned long *inlenp)
 {
 	z_stream s;
 	int err = 0;
@@ -304,7 +301,65 @@ int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 		}
 	} while (r == Z_BUF_ERROR);
 	*lenp = s.next_out - (unsigned char *) dst;
+	*inlenp = s.next_in - src;
 	inflateEnd(&s);
 
 	return err;
 }
+
+/*
+ * Uncompress blocks compressed with zlib without headers
+ */
+int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
+						int stoponerr, int offset)
+{
+	unsigned long inlen;
+
+	return zunzip_stream(dst, dstlen, src, lenp, stoponerr, offset, &inlen);
+}
+
+int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+{
+	unsigned long srclen = *lenp, pos = 0, done = 0;
+	int ret;
+
+	/*
+	 * There may be several gzip members one after the other, e.g. from a
+	 * blocked compressor such as bgzip, so decompress each in turn
+	 */
+	for (;;) {
+		unsigned long len = srclen - pos, inlen;
+		int offset;
+
+		offset = gzip_parse_header(src + pos, len);
+		if (offset < 0) {
+			/* junk after the last member is ignored */
+			if (!pos)
+				return offset;
+			break;
+		}
+		ret = zunzip_stream(dst + done, dstlen - done, src + pos, &len,
+				    1, offset, &inlen);
+		if (ret && pos) {
+			/* junk after the last member may look like a header */
+			ret = 0;
+			break;
+		}
+		done += len;
+		if (ret)
+			break;
+
+		/* skip the CRC and size which follow the compressed data */
+		pos += inlen + 8;
+		if (pos + 10 >= srclen || src[pos] != HEADER0 ||
+		    src[pos + 1] != HEADER1)
+			break;
+		if (done >= dstlen) {
+			ret = -ENOBUFS;	/* no room for the next member */
+			break;
+		}
+	}
+	*lenp = done;
+
+	return ret;
+}
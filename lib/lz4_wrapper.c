@@ -15,22 +15,25 @@
 #include "lz4.c"	/* #include for inlining, do not link! */
 
 #define LZ4F_BLOCKUNCOMPRESSED_FLAG 0x80000000U
+#define LZ4F_SKIPPABLE_MAGIC	0x184d2a50U
+#define LZ4F_SKIPPABLE_MASK	0xfffffff0U
 
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 {
 	const void *end = dst + *dstn;
 	const void *in = src;
 	void *out = dst;
-	int has_block_checksum;
+	int has_block_checksum, has_content_checksum;
 	int ret;
 	*dstn = 0;
 
+next_frame:
 	{ /* With in-place decompression the header may become invalid later. */
 		u32 magic;
 		u8 flags, version, independent_blocks, has_content_size;
 		u8 block_desc;
 
-		if (srcn < sizeof(u32) + 3*sizeof(u8))
+		if (in - src + sizeof(u32) + 3*sizeof(u8) > srcn)
 			return -EINVAL;	/* input overrun */
 
 		magic = get_unaligned_le32(in);
@@ -44,8 +47,8 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		independent_blocks = (flags >> 5) & 0x1;
 		has_block_checksum = (flags >> 4) & 0x1;
 		has_content_size = (flags >> 3) & 0x1;
+		has_content_checksum = (flags >> 2) & 0x1;
 
-		/* We assume there's always only a single, standard frame. */
 		if (magic != LZ4F_MAGIC || version != 1)
 			return -EPROTONOSUPPORT;	/* unknown format */
 		if ((flags & 0x03) || (block_desc & 0x8f))
@@ -54,7 +57,7 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 			return -EPROTONOSUPPORT; /* we can't support this yet */
 
 		if (has_content_size) {
-			if (srcn < sizeof(u32) + 3*sizeof(u8) + sizeof(u64))
+			if (in - src + sizeof(u64) + sizeof(u8) > srcn)
 				return -EINVAL;	/* input overrun */
 			in += sizeof(u64);
 		}
@@ -65,6 +68,10 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 	while (1) {
 		u32 block_header, block_size;
 
+		if (in - src + sizeof(u32) > srcn) {
+			ret = -EINVAL;		/* input overrun */
+			break;
+		}
 		block_header = get_unaligned_le32(in);
 		in += sizeof(u32);
 		block_size = block_header & ~LZ4F_BLOCKUNCOMPRESSED_FLAG;
@@ -104,6 +111,26 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 			in += sizeof(u32);
 	}
 
+	/*
+	 * Another frame may follow, e.g. when the data was compressed in
+	 * pieces by a parallel compressor. Skippable frames are ignored.
+	 */
+	if (!ret && has_content_checksum)
+		in += sizeof(u32);
+	while (!ret && in - src + 2 * sizeof(u32) <= srcn) {
+		u32 magic = get_unaligned_le32(in);
+
+		if (magic == LZ4F_MAGIC) {
+			if (out < end)
+				goto next_frame;
+			ret = -ENOBUFS;	/* no room for the next frame */
+			break;
+		}
+		if ((magic & LZ4F_SKIPPABLE_MASK) != LZ4F_SKIPPABLE_MAGIC)
+			break;
+		in += 2 * sizeof(u32) + get_unaligned_le32(in + sizeof(u32));
+	}
+
 	*dstn = out - dst;
 	return ret;
 }
@@ -28,6 +28,128 @@ static void *unflatten_dt_alloc(void **mem, unsigned long size,
 	return res;
 }
 
+/**
+ * unflatten_unit_name() - Find the name to use for a node without one
+ *
+ * @pathp: Node path as stored in the flat tree
+ * @szp: Returns the length of the name, including the terminator
+ * Return: pointer to the start of the name within @pathp
+ */
+static const char *unflatten_unit_name(const char *pathp, int *szp)
+{
+	const char *p1 = pathp, *ps = pathp, *pa = NULL;
+
+	while (*p1) {
+		if ((*p1) == '@')
+			pa = p1;
+		if ((*p1) == '/')
+			ps = p1 + 1;
+		p1++;
+	}
+	if (pa < ps)
+		pa = p1;
+	*szp = (pa - ps) + 1;
+
+	return ps;
+}
+
+/* Deepest flat tree which unflatten_dt_size() can handle */
+#define UNFLATTEN_MAX_DEPTH	64
+
+/**
+ * unflatten_dt_size() - Work out the memory needed to unflatten a tree
+ *
+ * This makes a single pass over the structure block, adding up exactly what
+ * unflatten_dt_node() allocates for each node and property, so that the live
+ * tree can be built into one allocation of the right size.
+ *
+ * @blob: Flat device tree to scan
+ * Return: number of bytes needed, or 0 if the tree could not be scanned
+ */
+static unsigned long unflatten_dt_size(const void *blob)
+{
+	unsigned long fpsize[UNFLATTEN_MAX_DEPTH + 1];
+	const char *unnamed = NULL;
+	unsigned long size = 0;
+	int offset = 0, next;
+	int depth = 0;
+	uint32_t tag;
+
+	fpsize[0] = 0;
+	do {
+		tag = fdt_next_tag(blob, offset, &next);
+		if ((tag == FDT_BEGIN_NODE || tag == FDT_END_NODE) && unnamed) {
+			int sz;
+
+			/* add the "name" property unflatten_dt_node() creates */
+			unflatten_unit_name(unnamed, &sz);
+			size = ALIGN(size, __alignof__(struct property));
+			size += sizeof(struct property) + sz;
+			unnamed = NULL;
+		}
+
+		switch (tag) {
+		case FDT_BEGIN_NODE: {
+			unsigned long parent = fpsize[depth];
+			const char *pathp;
+			unsigned int allocl;
+			int l;
+
+			if (depth == UNFLATTEN_MAX_DEPTH) {
+				debug("unflatten: tree too deep\n");
+				return 0;
+			}
+			pathp = fdt_get_name(blob, offset, &l);
+			if (!pathp)
+				return 0;
+			allocl = ++l;
+			if (*pathp != '/') {
+				/* see unflatten_dt_node() for the path size */
+				if (!parent) {
+					parent = 1;
+					allocl = 2;
+				} else {
+					parent += l;
+					allocl = parent;
+				}
+			} else {
+				unnamed = pathp;
+			}
+			fpsize[++depth] = parent;
+			size = ALIGN(size, __alignof__(struct device_node));
+			size += sizeof(struct device_node) + allocl;
+			break;
+		}
+		case FDT_PROP:
+			if (unnamed) {
+				const char *pname;
+
+				if (!fdt_getprop_by_offset(blob, offset, &pname,
+							   NULL))
+					return 0;
+				if (!strcmp(pname, "name"))
+					unnamed = NULL;
+			}
+			size = ALIGN(size, __alignof__(struct property));
+			size += sizeof(struct property);
+			break;
+		case FDT_END_NODE:
+			if (!depth)
+				return 0;
+			/* the root node is the only one unflattened */
+			if (!--depth)
+				return size;
+			break;
+		case FDT_END:
+			if (next < 0)
+				debug("unflatten: error %d scanning FDT\n",
+				      next);
+			return next < 0 ? 0 : size;
+		}
+		offset = next;
+	} while (1);
+}
+
 /**
  * unflatten_dt_node() - Alloc and populate a device_node from the flat tree
  * @blob: The parent device tree blob
@@ -36,18 +158,19 @@ static void *unflatten_dt_alloc(void **mem, unsigned long size,
  * @dad: Parent struct device_node
  * @nodepp: The device_node tree created by the call
  * @fpsize: Size of the node path up at t05he current depth.
- * @dryrun: If true, do not allocate device nodes but still calculate needed
- * memory size
+ *
+ * The allocations made here must match those added up by unflatten_dt_size().
  */
 static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 			       struct device_node *dad,
 			       struct device_node **nodepp,
-			       unsigned long fpsize, bool dryrun)
+			       unsigned long fpsize)
 {
 	const __be32 *p;
 	struct device_node *np;
 	struct property *pp, **prev_pp = NULL;
 	const char *pathp;
+	char *fn;
 	int l;
 	unsigned int allocl;
 	static int depth;
@@ -93,38 +216,34 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 
 	np = unflatten_dt_alloc(&mem, sizeof(struct device_node) + allocl,
 				__alignof__(struct device_node));
-	if (!dryrun) {
-		char *fn;
-
-		fn = (char *)np + sizeof(*np);
-		if (new_format) {
-			np->name = pathp;
-			has_name = 1;
-		}
-		np->full_name = fn;
-		if (new_format) {
-			/* rebuild full path for new format */
-			if (dad && dad->parent) {
-				strcpy(fn, dad->full_name);
+	fn = (char *)np + sizeof(*np);
+	if (new_format) {
+		np->name = pathp;
+		has_name = 1;
+	}
+	np->full_name = fn;
+	if (new_format) {
+		/* rebuild full path for new format */
+		if (dad && dad->parent) {
+			strcpy(fn, dad->full_name);
 #ifdef DEBUG
-				if ((strlen(fn) + l + 1) != allocl) {
-					debug("%s: p: %d, l: %d, a: %d\n",
-					      pathp, (int)strlen(fn), l,
-					      allocl);
-				}
-#endif
-				fn += strlen(fn);
+			if ((strlen(fn) + l + 1) != allocl) {
+				debug("%s: p: %d, l: %d, a: %d\n",
+				      pathp, (int)strlen(fn), l,
+				      allocl);
 			}
-			*(fn++) = '/';
+#endif
+			fn += strlen(fn);
 		}
-		memcpy(fn, pathp, l);
+		*(fn++) = '/';
+	}
+	memcpy(fn, pathp, l);
 
-		prev_pp = &np->properties;
-		if (dad != NULL) {
-			np->parent = dad;
-			np->sibling = dad->child;
-			dad->child = np;
-		}
+	prev_pp = &np->properties;
+	if (dad != NULL) {
+		np->parent = dad;
+		np->sibling = dad->child;
+		dad->child = np;
 	}
 	/* process properties */
 	for (offset = fdt_first_property_offset(blob, *poffset);
@@ -147,73 +266,59 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 			has_name = 1;
 		pp = unflatten_dt_alloc(&mem, sizeof(struct property),
 					__alignof__(struct property));
-		if (!dryrun) {
-			/*
-			 * We accept flattened tree phandles either in
-			 * ePAPR-style "phandle" properties, or the
-			 * legacy "linux,phandle" properties.  If both
-			 * appear and have different values, things
-			 * will get weird.  Don't do that. */
-			if ((strcmp(pname, "phandle") == 0) ||
-			    (strcmp(pname, "linux,phandle") == 0)) {
-				if (np->phandle == 0)
-					np->phandle = be32_to_cpup(p);
-			}
-			/*
-			 * And we process the "ibm,phandle" property
-			 * used in pSeries dynamic device tree
-			 * stuff */
-			if (strcmp(pname, "ibm,phandle") == 0)
+		/*
+		 * We accept flattened tree phandles either in
+		 * ePAPR-style "phandle" properties, or the
+		 * legacy "linux,phandle" properties.  If both
+		 * appear and have different values, things
+		 * will get weird.  Don't do that. */
+		if ((strcmp(pname, "phandle") == 0) ||
+		    (strcmp(pname, "linux,phandle") == 0)) {
+			if (np->phandle == 0)
 				np->phandle = be32_to_cpup(p);
-			pp->name = (char *)pname;
-			pp->length = sz;
-			pp->value = (__be32 *)p;
-			*prev_pp = pp;
-			prev_pp = &pp->next;
 		}
+		/*
+		 * And we process the "ibm,phandle" property
+		 * used in pSeries dynamic device tree
+		 * stuff */
+		if (strcmp(pname, "ibm,phandle") == 0)
+			np->phandle = be32_to_cpup(p);
+		pp->name = (char *)pname;
+		pp->length = sz;
+		pp->value = (__be32 *)p;
+		*prev_pp = pp;
+		prev_pp = &pp->next;
 	}
 	/*
 	 * with version 0x10 we may not have the name property, recreate
 	 * it here from the unit name if absent
 	 */
 	if (!has_name) {
-		const char *p1 = pathp, *ps = pathp, *pa = NULL;
+		const char *ps;
 		int sz;
 
-		while (*p1) {
-			if ((*p1) == '@')
-				pa = p1;
-			if ((*p1) == '/')
-				ps = p1 + 1;
-			p1++;
-		}
-		if (pa < ps)
-			pa = p1;
-		sz = (pa - ps) + 1;
+		ps = unflatten_unit_name(pathp, &sz);
 		pp = unflatten_dt_alloc(&mem, sizeof(struct property) + sz,
 					__alignof__(struct property));
-		if (!dryrun) {
-			pp->name = "name";
-			pp->length = sz;
-			pp->value = pp + 1;
-			*prev_pp = pp;
-			prev_pp = &pp->next;
-			memcpy(pp->value, ps, sz - 1);
-			((char *)pp->value)[sz - 1] = 0;
-			debug("fixed up name for %s -> %s\n", pathp,
-			      (char *)pp->value);
-		}
+		pp->name = "name";
+		pp->length = sz;
+		pp->value = pp + 1;
+		*prev_pp = pp;
+		prev_pp = &pp->next;
+		memcpy(pp->value, ps, sz - 1);
+		((char *)pp->value)[sz - 1] = 0;
+		debug("fixed up name for %s -> %s\n", pathp,
+		      (char *)pp->value);
 	}
-	if (!dryrun) {
-		*prev_pp = NULL;
-		if (!has_name)
-			np->name = of_get_property(np, "name", NULL);
-		np->type = of_get_property(np, "device_type", NULL);
+	*prev_pp = NULL;
+	if (!has_name)
+		np->name = of_get_property(np, "name", NULL);
+	np->type = of_get_property(np, "device_type", NULL);
 
-		if (!np->name)
-			np->name = "<NULL>";
-		if (!np->type)
-			np->type = "<NULL>";	}
+	if (!np->name)
+		np->name = "<NULL>";
+	if (!np->type)
+		np->type = "<NULL>";
 
 	old_depth = depth;
 	*poffset = fdt_next_node(blob, *poffset, &depth);
@@ -221,7 +326,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 		depth = 0;
 	while (*poffset > 0 && depth > old_depth) {
 		mem = unflatten_dt_node(blob, mem, poffset, np, NULL,
-					fpsize, dryrun);
+					fpsize);
 		if (!mem)
 			return NULL;
 	}
@@ -235,7 +340,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 	 * Reverse the child list. Some drivers assumes node order matches .dts
 	 * node order
 	 */
-	if (!dryrun && np->child) {
+	if (np->child) {
 		struct device_node *child = np->child;
 		np->child = NULL;
 		while (child) {
@@ -277,9 +382,7 @@ int unflatten_device_tree(const void *blob, struct device_node **mynodes)
 	}
 
 	/* First pass, scan for size */
-	start = 0;
-	size = (unsigned long)unflatten_dt_node(blob, NULL, &start, NULL, NULL,
-						0, true);
+	size = unflatten_dt_size(blob);
 	if (!size)
 		return -EFAULT;
 	size = ALIGN(size, 4);
@@ -288,6 +391,8 @@ int unflatten_device_tree(const void *blob, struct device_node **mynodes)
 
 	/* Allocate memory for the expanded device tree */
 	mem = malloc(size + 4);
+	if (!mem)
+		return -ENOMEM;
 	memset(mem, '\0', size);
 
 	*(__be32 *)(mem + size) = cpu_to_be32(0xdeadbeef);
@@ -296,7 +401,7 @@ int unflatten_device_tree(const void *blob, struct device_node **mynodes)
 
 	/* Second pass, do actual unflattening */
 	start = 0;
-	unflatten_dt_node(blob, mem, &start, NULL, mynodes, 0, false);
+	unflatten_dt_node(blob, mem, &start, NULL, mynodes, 0);
 	if (be32_to_cpup(mem + size) != 0xdeadbeef) {
 		debug("End of tree marker overwritten: %08x\n",
 		      be32_to_cpup(mem + size));
@@ -318,6 +423,12 @@ int of_live_build(const void *fdt_blob, struct device_node **rootp)
 		debug("Failed to create live tree: err=%d\n", ret);
 		return ret;
 	}
+	if (CONFIG_IS_ENABLED(OF_LOOKUP_INDEX)) {
+		/* Lookups still work without the index, just more slowly */
+		ret = of_index_build(*rootp);
+		if (ret)
+			debug("Failed to index live tree: err=%d\n", ret);
+	}
 	ret = of_alias_scan();
 	if (ret) {
 		debug("Failed to scan live tree aliases: err=%d\n", ret);
@@ -0,0 +1,314 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Decompress a file while it is being loaded
+ *
+ * Loading a kernel over the network leaves the CPU idle for most of the time,
+ * waiting for the next packet. Use that time to decompress the data which
+ * has arrived so far, so that the decompressed file is ready soon after the
+ * last packet.
+ */
+
+#define LOG_CATEGORY	LOGC_BOOT
+
+#include <common.h>
+#include <env.h>
+#include <gzip.h>
+#include <image.h>
+#include <log.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <unzip_load.h>
+#include <linux/sizes.h>
+#include <linux/zstd.h>
+#include <u-boot/zlib.h>
+
+/* Enough of the file to recognise the compression and read a zstd header */
+#define UNZIP_LOAD_HDR_SIZE	18
+
+/* Most data to decompress in one poll, so that packets are not held up */
+#define UNZIP_LOAD_CHUNK	SZ_64K
+
+/**
+ * struct unzip_load - State for decompressing a file while it is loaded
+ *
+ * @active: true if the file is being decompressed
+ * @comp: Compression type (IH_COMP_...), IH_COMP_NONE if not yet known
+ * @addr: Address the compressed file is being loaded to
+ * @loaded: Number of bytes of the compressed file loaded without a gap
+ * @done: Number of bytes of the compressed file decompressed so far
+ * @dest: Address to decompress to
+ * @out: Number of bytes written to @dest so far
+ * @between: true if the last frame (or gzip member) has ended and nothing has
+ *	been decompressed since, so that data which does not start a new frame
+ *	is junk after the end
+ * @frame_end: Offset in the compressed file where the last frame ended
+ * @ended: true if junk has been found after the last frame, so that any
+ *	further data is ignored
+ * @zs: zlib state, for gzip
+ * @dstream: zstd state
+ * @workspace: Memory for @dstream
+ */
+static struct unzip_load {
+	bool active;
+	int comp;
+	ulong addr;
+	ulong loaded;
+	ulong done;
+	ulong dest;
+	ulong out;
+	bool between;
+	ulong frame_end;
+	bool ended;
+	z_stream zs;
+	zstd_dstream *dstream;
+	void *workspace;
+} unzip_load;
+
+void unzip_load_abort(void)
+{
+	struct unzip_load *ul = &unzip_load;
+
+	if (CONFIG_IS_ENABLED(GZIP) && ul->comp == IH_COMP_GZIP)
+		inflateEnd(&ul->zs);
+	free(ul->workspace);
+	ul->workspace = NULL;
+	ul->comp = IH_COMP_NONE;
+	ul->active = false;
+}
+
+int unzip_load_start(ulong addr)
+{
+	struct unzip_load *ul = &unzip_load;
+
+	unzip_load_abort();
+	env_set("unzipsize", NULL);
+	ul->dest = env_get_hex("unzipaddr", 0);
+	if (!ul->dest)
+		return 0;
+	ul->addr = addr;
+	ul->loaded = 0;
+	ul->done = 0;
+	ul->out = 0;
+	ul->between = false;
+	ul->frame_end = 0;
+	ul->ended = false;
+	ul->active = true;
+
+	return 0;
+}
+
+/**
+ * unzip_load_init() - Set up decompression once the file type is known
+ *
+ * @in: Start of the file
+ * @len: Number of bytes available at @in
+ * Return: 0 if OK, -EAGAIN if more data is needed, -ENOENT if the file is not
+ * compressed in a supported format, other -ve value on error
+ */
+static int unzip_load_init(const u8 *in, ulong len)
+{
+	struct unzip_load *ul = &unzip_load;
+	int comp, ret;
+
+	comp = image_decomp_type(in, len);
+	if (comp == IH_COMP_GZIP && CONFIG_IS_ENABLED(GZIP)) {
+		ul->zs.zalloc = gzalloc;
+		ul->zs.zfree = gzfree;
+		ret = inflateInit2(&ul->zs, 16 + MAX_WBITS);
+		if (ret != Z_OK)
+			return -ENOMEM;
+	} else if (comp == IH_COMP_ZSTD && CONFIG_IS_ENABLED(ZSTD)) {
+		zstd_frame_header params;
+		size_t size;
+
+		/* the window is kept separately, so allocate just enough */
+		if (zstd_get_frame_header(&params, in, len))
+			return len < UNZIP_LOAD_HDR_SIZE ? -EAGAIN : -EINVAL;
+		size = zstd_dstream_workspace_bound(params.windowSize);
+		ul->workspace = malloc(size);
+		if (!ul->workspace)
+			return log_msg_ret("ws", -ENOMEM);
+		ul->dstream = zstd_init_dstream(params.windowSize, ul->workspace,
+						size);
+		if (!ul->dstream)
+			return -EINVAL;
+	} else {
+		return -ENOENT;
+	}
+	ul->comp = comp;
+
+	return 0;
+}
+
+/**
+ * unzip_load_frame_end() - Note that a frame has ended
+ *
+ * @used: Number of bytes used from the data passed to unzip_load_run()
+ */
+static void unzip_load_frame_end(ulong used)
+{
+	struct unzip_load *ul = &unzip_load;
+
+	ul->between = true;
+	ul->frame_end = ul->done + used;
+}
+
+/**
+ * unzip_load_run() - Decompress some more data
+ *
+ * A frame may be followed by junk, which the decoder may partly consume
+ * before it sees the problem, so @between is only cleared once more output
+ * is produced.
+ *
+ * @in: Data to decompress, which follows on from the data already decompressed
+ * @len: Number of bytes at @in
+ * @out: Place to put decompressed data
+ * @max: Space available at @out
+ * Return: number of bytes used from @in, or -EBADMSG if the data is corrupt
+ */
+static long unzip_load_run(const void *in, ulong len, void *out, ulong max)
+{
+	struct unzip_load *ul = &unzip_load;
+
+	if (CONFIG_IS_ENABLED(GZIP) && ul->comp == IH_COMP_GZIP) {
+		z_stream *zs = &ul->zs;
+		int ret;
+
+		zs->next_in = (void *)in;
+		zs->avail_in = len;
+		zs->next_out = out;
+		zs->avail_out = max;
+		ret = inflate(zs, Z_SYNC_FLUSH);
+		ul->out += max - zs->avail_out;
+		if (zs->avail_out != max)
+			ul->between = false;
+		if (ret == Z_STREAM_END) {
+			/* another gzip member may follow */
+			inflateReset(zs);
+			unzip_load_frame_end(len - zs->avail_in);
+		} else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+			return -EBADMSG;
+		}
+
+		return len - zs->avail_in;
+	} else if (CONFIG_IS_ENABLED(ZSTD) && ul->comp == IH_COMP_ZSTD) {
+		zstd_in_buffer ib = { .src = in, .size = len };
+		zstd_out_buffer ob = { .dst = out, .size = max };
+		size_t ret;
+
+		ret = zstd_decompress_stream(ul->dstream, &ob, &ib);
+		ul->out += ob.pos;
+		if (ob.pos)
+			ul->between = false;
+		if (zstd_is_error(ret))
+			return -EBADMSG;
+		else if (!ret)
+			unzip_load_frame_end(ib.pos);
+
+		return ib.pos;
+	}
+
+	return -EBADMSG;
+}
+
+/**
+ * unzip_load_process() - Decompress the file up to a given offset
+ *
+ * @end: Offset of the end of the data available to decompress
+ * Return: 0 if OK, -EAGAIN if more data is needed to start, -ve on error
+ */
+static int unzip_load_process(ulong end)
+{
+	struct unzip_load *ul = &unzip_load;
+	const void *in;
+	void *out;
+	long ret = 0;
+
+	in = map_sysmem(ul->addr, end);
+	if (ul->comp == IH_COMP_NONE) {
+		ret = unzip_load_init(in, end);
+		if (ret) {
+			unmap_sysmem(in);
+			return ret;
+		}
+	}
+
+	out = map_sysmem(ul->dest, CONFIG_UNZIP_LOAD_MAX);
+	while (ul->done < end && !ul->ended) {
+		ulong start = ul->done, prev = ul->out;
+
+		ret = unzip_load_run(in + start, end - start, out + prev,
+				     CONFIG_UNZIP_LOAD_MAX - prev);
+		if (ret == -EBADMSG && ul->between &&
+		    image_decomp_type(in + ul->frame_end,
+				      end - ul->frame_end) != ul->comp) {
+			/* ignore junk after the last frame, like gunzip does */
+			ul->ended = true;
+			ret = 0;
+			break;
+		}
+		if (ret < 0)
+			break;
+		ul->done += ret;
+		if (!ret && ul->out == prev) {
+			/* no progress, so the output buffer must be full */
+			ret = -E2BIG;
+			break;
+		}
+	}
+	unmap_sysmem(out);
+	unmap_sysmem(in);
+
+	return ret < 0 ? ret : 0;
+}
+
+void unzip_load_update(ulong offset, ulong len)
+{
+	struct unzip_load *ul = &unzip_load;
+
+	/*
+	 * Data after a gap is decompressed once the gap is filled, or at the
+	 * end
+	 */
+	if (ul->active && offset <= ul->loaded && offset + len > ul->loaded)
+		ul->loaded = offset + len;
+}
+
+void unzip_load_poll(void)
+{
+	struct unzip_load *ul = &unzip_load;
+	int ret;
+
+	if (!ul->active || ul->ended || ul->done >= ul->loaded ||
+	    (ul->comp == IH_COMP_NONE && ul->loaded < UNZIP_LOAD_HDR_SIZE))
+		return;
+
+	ret = unzip_load_process(min(ul->loaded, ul->done + UNZIP_LOAD_CHUNK));
+	if (ret && ret != -EAGAIN) {
+		if (ret != -ENOENT)
+			log_err("Cannot decompress while loading (err=%d)\n",
+				ret);
+		unzip_load_abort();
+	}
+}
+
+int unzip_load_finish(ulong size)
+{
+	struct unzip_load *ul = &unzip_load;
+	int ret;
+
+	if (!ul->active)
+		return 0;
+	ret = unzip_load_process(size);
+	if (!ret && !ul->between)
+		ret = -EINVAL;		/* the last frame is incomplete */
+	if (!ret)
+		printf("Uncompressed %lx bytes to %08lx\n", ul->out, ul->dest);
+	else if (ret != -ENOENT)
+		log_err("Cannot decompress file (err=%d)\n", ret);
+	unzip_load_abort();
+	if (ret)
+		return ret == -ENOENT ? 0 : ret;
+
+	return env_set_hex("unzipsize", ul->out);
+}
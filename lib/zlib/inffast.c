@@ -31,6 +31,40 @@
 #  define PUP(a) *++(a)
 #endif
 
+/*
+   With WIDE_REFILL (see inffast.h), the 64-bit bit accumulator is topped up
+   with a single eight-byte load, instead of one byte at a time. The bits above the
+   count in the accumulator then hold a copy of the next input, so bytes are
+   merged in with | rather than +.  With CONFIG_ZLIB_INFLATE_FAST, long
+   matches are copied with memcpy(), doubling the amount copied each time
+   when the match overlaps itself.
+ */
+#if IS_ENABLED(CONFIG_ZLIB_INFLATE_FAST)
+/* Matches shorter than this are copied a byte at a time */
+#define COPY_MATCH_MIN 16
+
+/* Copy a match of len bytes from dist bytes back; return the new out */
+local unsigned char FAR *copy_match(unsigned char FAR *out, unsigned dist,
+                                    unsigned len)
+{
+    unsigned char FAR *from = out - dist;
+
+    if (dist == 1) {
+        memset(out, *from, len);
+        return out + len;
+    }
+    while (len > dist) {
+        zmemcpy(out, from, dist);
+        out += dist;
+        len -= dist;
+        dist <<= 1;
+    }
+    zmemcpy(out, from, len);
+
+    return out + len;
+}
+#endif
+
 /*
    Decode literal, length, and distance codes and write out the resulting
    literal and match bytes until either not enough input or output is
@@ -42,8 +76,8 @@
    Entry assumptions:
 
         state->mode == LEN
-        strm->avail_in >= 6
-        strm->avail_out >= 258
+        strm->avail_in >= INFLATE_FAST_MIN_HAVE (6, or 8 with WIDE_REFILL)
+        strm->avail_out >= INFLATE_FAST_MIN_LEFT (258)
         start >= strm->avail_out
         state->bits < 8
 
@@ -98,18 +132,18 @@ void inflate_fast(z_streamp strm, unsigned start)
     /* copy state to local variables */
     state = (struct inflate_state FAR *)strm->state;
     in = strm->next_in - OFF;
-    last = in + (strm->avail_in - 5);
-    if (in > last && strm->avail_in > 5) {
+    last = in + (strm->avail_in - (INFLATE_FAST_MIN_HAVE - 1));
+    if (in > last && strm->avail_in > INFLATE_FAST_MIN_HAVE - 1) {
         /*
          * overflow detected, limit strm->avail_in to the
          * max. possible size and recalculate last
          */
 	strm->avail_in = 0xffffffff - (uintptr_t)in;
-        last = in + (strm->avail_in - 5);
+        last = in + (strm->avail_in - (INFLATE_FAST_MIN_HAVE - 1));
     }
     out = strm->next_out - OFF;
     beg = out - (start - strm->avail_out);
-    end = out + (strm->avail_out - 257);
+    end = out + (strm->avail_out - (INFLATE_FAST_MIN_LEFT - 1));
 #ifdef INFLATE_STRICT
     dmax = state->dmax;
 #endif
@@ -128,10 +162,16 @@ void inflate_fast(z_streamp strm, unsigned start)
        input data or output space */
     do {
         if (bits < 15) {
-            hold += (unsigned long)(PUP(in)) << bits;
+#ifdef WIDE_REFILL
+            hold |= (unsigned long)get_unaligned_le64(in + OFF) << bits;
+            in += (63 - bits) >> 3;
+            bits |= 56;
+#else
+            hold |= (unsigned long)(PUP(in)) << bits;
             bits += 8;
-            hold += (unsigned long)(PUP(in)) << bits;
+            hold |= (unsigned long)(PUP(in)) << bits;
             bits += 8;
+#endif
         }
         this = lcode[hold & lmask];
       dolen:
@@ -150,7 +190,7 @@ void inflate_fast(z_streamp strm, unsigned start)
             op &= 15;                           /* number of extra bits */
             if (op) {
                 if (bits < op) {
-                    hold += (unsigned long)(PUP(in)) << bits;
+                    hold |= (unsigned long)(PUP(in)) << bits;
                     bits += 8;
                 }
                 len += (unsigned)hold & ((1U << op) - 1);
@@ -159,9 +199,9 @@ void inflate_fast(z_streamp strm, unsigned start)
             }
             Tracevv((stderr, "inflate:         length %u\n", len));
             if (bits < 15) {
-                hold += (unsigned long)(PUP(in)) << bits;
+                hold |= (unsigned long)(PUP(in)) << bits;
                 bits += 8;
-                hold += (unsigned long)(PUP(in)) << bits;
+                hold |= (unsigned long)(PUP(in)) << bits;
                 bits += 8;
             }
             this = dcode[hold & dmask];
@@ -174,10 +214,10 @@ void inflate_fast(z_streamp strm, unsigned start)
                 dist = (unsigned)(this.val);
                 op &= 15;                       /* number of extra bits */
                 if (bits < op) {
-                    hold += (unsigned long)(PUP(in)) << bits;
+                    hold |= (unsigned long)(PUP(in)) << bits;
                     bits += 8;
                     if (bits < op) {
-                        hold += (unsigned long)(PUP(in)) << bits;
+                        hold |= (unsigned long)(PUP(in)) << bits;
                         bits += 8;
                     }
                 }
@@ -252,6 +292,11 @@ void inflate_fast(z_streamp strm, unsigned start)
                             PUP(out) = PUP(from);
                     }
                 }
+#if IS_ENABLED(CONFIG_ZLIB_INFLATE_FAST)
+                else if (len >= COPY_MATCH_MIN) {
+                    out = copy_match(out + OFF, dist, len) - OFF;
+                }
+#endif
                 else {
 		    unsigned short *sout;
 		    unsigned long loops;
@@ -331,9 +376,12 @@ void inflate_fast(z_streamp strm, unsigned start)
     /* update state and return */
     strm->next_in = in + OFF;
     strm->next_out = out + OFF;
-    strm->avail_in = (unsigned)(in < last ? 5 + (last - in) : 5 - (in - last));
+    strm->avail_in = (unsigned)(in < last ?
+                                (INFLATE_FAST_MIN_HAVE - 1) + (last - in) :
+                                (INFLATE_FAST_MIN_HAVE - 1) - (in - last));
     strm->avail_out = (unsigned)(out < end ?
-                                 257 + (end - out) : 257 - (out - end));
+                                 (INFLATE_FAST_MIN_LEFT - 1) + (end - out) :
+                                 (INFLATE_FAST_MIN_LEFT - 1) - (out - end));
     state->hold = hold;
     state->bits = bits;
     return;
@@ -8,4 +8,13 @@
    subject to change. Applications should only use zlib.h.
  */
 
+/* Use a single load to refill the bit accumulator, if it is 64 bits wide */
+#if IS_ENABLED(CONFIG_ZLIB_INFLATE_FAST) && BITS_PER_LONG == 64
+#  define WIDE_REFILL
+#  define INFLATE_FAST_MIN_HAVE 8
+#else
+#  define INFLATE_FAST_MIN_HAVE 6
+#endif
+#define INFLATE_FAST_MIN_LEFT 258
+
 void inflate_fast OF((z_streamp strm, unsigned start));
@@ -722,7 +722,8 @@ int ZEXPORT inflate(z_streamp strm, int flush)
             state->mode = LEN;
         case LEN:
 	    schedule();
-            if (have >= 6 && left >= 258) {
+            if (have >= INFLATE_FAST_MIN_HAVE &&
+                left >= INFLATE_FAST_MIN_LEFT) {
                 RESTORE();
                 inflate_fast(strm, out);
                 LOAD();
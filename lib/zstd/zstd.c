@@ -13,8 +13,8 @@
 
 int zstd_decompress(struct abuf *in, struct abuf *out)
 {
+	size_t wsize, len, size = 0;
 	zstd_dctx *ctx;
-	size_t wsize, len;
 	void *workspace;
 	int ret;
 
@@ -34,13 +34,21 @@ int zstd_decompress(struct abuf *in, struct abuf *out)
 	}
 
 	/*
-	 * Find out how large the frame actually is, there may be junk at
-	 * the end of the frame that zstd_decompress_dctx() can't handle.
+	 * Find out how large the frames actually are, there may be junk at
+	 * the end of the last frame that zstd_decompress_dctx() can't handle.
+	 * There can be several frames, e.g. when the data was compressed in
+	 * pieces by a parallel compressor, and these are decompressed one
+	 * after the other by zstd_decompress_dctx().
 	 */
-	len = zstd_find_frame_compressed_size(abuf_data(in), abuf_size(in));
-	if (zstd_is_error(len)) {
+	for (len = 0; len < abuf_size(in); len += size) {
+		size = zstd_find_frame_compressed_size(abuf_data(in) + len,
+						       abuf_size(in) - len);
+		if (zstd_is_error(size))
+			break;
+	}
+	if (!len) {
 		log_err("%s: failed to detect compressed size: %d\n", __func__,
-			zstd_get_error_code(len));
+			zstd_get_error_code(size));
 		ret = -EINVAL;
 		goto do_free;
 	}
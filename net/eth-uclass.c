@@ -28,10 +28,13 @@ DECLARE_GLOBAL_DATA_PTR;
  * struct eth_device_priv - private structure for each Ethernet device
  *
  * @state: The state of the Ethernet MAC driver (defined by enum eth_state_t)
+ * @running: true if the device has been started
+ * @stats: Receive and transmit statistics
  */
 struct eth_device_priv {
 	enum eth_state_t state;
 	bool running;
+	struct eth_stats stats;
 };
 
 /**
@@ -376,8 +379,28 @@ int eth_is_active(struct udevice *dev)
 	return priv->state == ETH_STATE_ACTIVE;
 }
 
+const struct eth_stats *eth_get_stats(const struct udevice *dev)
+{
+	struct eth_device_priv *priv;
+
+	if (!device_active(dev))
+		return NULL;
+
+	priv = dev_get_uclass_priv(dev);
+	return &priv->stats;
+}
+
+void eth_count_rx_drop(struct udevice *dev, uint dropped, uint overruns)
+{
+	struct eth_device_priv *priv = dev_get_uclass_priv(dev);
+
+	priv->stats.rx_dropped += dropped;
+	priv->stats.rx_overruns += overruns;
+}
+
 int eth_send(void *packet, int length)
 {
+	struct eth_device_priv *priv;
 	struct udevice *current;
 	int ret;
 
@@ -388,10 +411,14 @@ int eth_send(void *packet, int length)
 	if (!eth_is_active(current))
 		return -EINVAL;
 
+	priv = dev_get_uclass_priv(current);
 	ret = eth_get_ops(current)->send(current, packet, length);
 	if (ret < 0) {
 		/* We cannot completely return the error at present */
 		debug("%s: send() returned error %d\n", __func__, ret);
+		priv->stats.tx_errors++;
+	} else {
+		priv->stats.tx_packets++;
 	}
 #if defined(CONFIG_CMD_PCAP)
 	if (ret >= 0)
@@ -402,7 +429,9 @@ int eth_send(void *packet, int length)
 
 int eth_rx(void)
 {
+	struct eth_device_priv *priv;
 	struct udevice *current;
+	struct eth_ops *ops;
 	uchar *packet;
 	int flags;
 	int ret;
@@ -415,25 +444,38 @@ int eth_rx(void)
 	if (!eth_is_active(current))
 		return -EINVAL;
 
-	/* Process up to 32 packets at one time */
+	priv = dev_get_uclass_priv(current);
+	ops = eth_get_ops(current);
+
+	/* Process up to ETH_PACKETS_BATCH_RECV packets at one time */
 	flags = ETH_RECV_CHECK_DEVICE;
 	for (i = 0; i < ETH_PACKETS_BATCH_RECV; i++) {
-		ret = eth_get_ops(current)->recv(current, flags, &packet);
+		ret = ops->recv(current, flags, &packet);
 		flags = 0;
-		if (ret > 0)
+		if (ret > 0) {
+			priv->stats.rx_bytes += ret;
 			net_process_received_packet(packet, ret);
-		if (ret >= 0 && eth_get_ops(current)->free_pkt)
-			eth_get_ops(current)->free_pkt(current, packet, ret);
+		}
+		if (ret >= 0 && ops->free_pkt)
+			ops->free_pkt(current, packet, ret);
 		if (ret <= 0)
 			break;
 	}
+	priv->stats.rx_packets += i;
+	if (i)
+		priv->stats.rx_polls++;
+	if (i == ETH_PACKETS_BATCH_RECV)
+		priv->stats.rx_full_batches++;
+
 	if (ret == -EAGAIN)
 		ret = 0;
 	if (ret < 0) {
 		/* We cannot completely return the error at present */
 		debug("%s: recv() returned error %d\n", __func__, ret);
+		priv->stats.rx_errors++;
+		return ret;
 	}
-	return ret;
+	return i;
 }
 
 int eth_initialize(void)
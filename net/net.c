@@ -88,6 +88,7 @@
 #include <env.h>
 #include <env_internal.h>
 #include <errno.h>
+#include <hash.h>
 #include <image.h>
 #include <log.h>
 #include <net.h>
@@ -104,6 +105,7 @@
 #include <miiphy.h>
 #include <status_led.h>
 #endif
+#include <unzip_load.h>
 #include <watchdog.h>
 #include <linux/compiler.h>
 #include <test/test.h>
@@ -417,6 +419,7 @@ int net_init(void)
 int net_loop(enum proto_t protocol)
 {
 	int ret = -EINVAL;
+	int i, rx = 0;
 	enum net_loop_state prev_net_state = net_state;
 
 #if defined(CONFIG_CMD_PING)
@@ -616,12 +619,23 @@ restart:
 		}
 
 		/*
-		 *	Check the ethernet for a new packet.  The ethernet
-		 *	receive routine will process it.
-		 *	Most drivers return the most recent packet size, but not
-		 *	errors that may have happened.
+		 *	Check the ethernet for new packets.  The ethernet
+		 *	receive routine processes a batch of them.  While the
+		 *	driver keeps handing up full batches, stay in the
+		 *	receive path instead of polling the console and the
+		 *	timers between them, so a burst does not overrun the
+		 *	receive ring.
 		 */
-		eth_rx();
+		for (i = 0; i < NET_RX_BURSTS; i++) {
+			rx = eth_rx();
+			if (rx < ETH_PACKETS_BATCH_RECV ||
+			    net_state != NETLOOP_CONTINUE)
+				break;
+		}
+
+		/* Nothing is waiting, so decompress while the sender works */
+		if (!rx && net_state == NETLOOP_CONTINUE)
+			unzip_load_poll();
 
 		/*
 		 *	Abort if ctrl-c was pressed.
@@ -688,6 +702,8 @@ restart:
 				       net_boot_file_size, net_boot_file_size);
 				env_set_hex("filesize", net_boot_file_size);
 				env_set_hex("fileaddr", image_load_addr);
+				hash_load_finish(net_boot_file_size);
+				unzip_load_finish(net_boot_file_size);
 			}
 			if (protocol != NETCONS && protocol != NCSI)
 				eth_halt();
@@ -714,6 +730,8 @@ restart:
 	}
 
 done:
+	hash_load_abort();
+	unzip_load_abort();
 #ifdef CONFIG_USB_KEYBOARD
 	net_busy_flag = 0;
 #endif
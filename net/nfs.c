@@ -32,11 +32,13 @@
 #ifdef CONFIG_SYS_DIRECT_FLASH_NFS
 #include <flash.h>
 #endif
+#include <hash.h>
 #include <image.h>
 #include <log.h>
 #include <net.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <unzip_load.h>
 #include "nfs.h"
 #include "bootp.h"
 #include <time.h>
@@ -109,6 +111,8 @@ static inline int store_block(uchar *src, unsigned offset, unsigned len)
 		memcpy(ptr, src, len);
 		unmap_sysmem(ptr);
 	}
+	hash_load_update(offset, src, len);
+	unzip_load_update(offset, len);
 
 	if (net_boot_file_size < (offset + len))
 		net_boot_file_size = newsize;
@@ -912,6 +916,8 @@ void nfs_start(void)
 		print_size(net_boot_file_expected_size_in_blocks << 9, "");
 	}
 	printf("\nLoad address: 0x%lx\nLoading: *\b", image_load_addr);
+	hash_load_start(image_load_addr);
+	unzip_load_start(image_load_addr);
 
 	net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
 	net_set_udp_handler(nfs_handler);
@@ -41,19 +41,29 @@ static u32 tcp_seq_max;
 static int tcp_activity_count;
 
 /*
- * Search for TCP_SACK and review the comments before the code section
- * TCP_SACK is the number of packets at the front of the stream
+ * Sequence ranges received beyond tcp_ack_edge, sorted and disjoint.
+ * The payload itself has already been handed to the application, which
+ * stores it by offset, so only the edges are kept: they are reported in
+ * the SACK option and advance tcp_ack_edge once the hole is filled.
  */
+static struct sack_edges tcp_ooo[TCP_SACK];
+static unsigned int tcp_ooo_cnt;
+static unsigned int tcp_ooo_last;	/* Range holding the latest segment */
 
-enum pkt_state {PKT, NOPKT};
-struct sack_r {
-	struct sack_edges se;
-	enum pkt_state st;
-};
+/* Delayed ACK state */
+static unsigned int tcp_unacked;
+static unsigned int tcp_rcv_mss;
+static bool tcp_ack_now;
 
-static struct sack_r edge_a[TCP_SACK];
-static unsigned int sack_idx;
-static unsigned int prev_len;
+/* Sequence number of the server's FIN, valid if tcp_fin_seen */
+static u32 tcp_fin_seq;
+static bool tcp_fin_seen;
+
+/* Receive window shift, zero unless the server agreed to scaling */
+static u8 tcp_rcv_wscale;
+
+#define SEQ_LT(a, b) ((s32)((a) - (b)) < 0)
+#define SEQ_GT(a, b) ((s32)((a) - (b)) > 0)
 
 /*
  * TCP lengths are stored as a rounded up number of 32 bit words.
@@ -204,6 +214,21 @@ int net_set_ack_options(union tcp_build_pkt *b)
 	return GET_TCP_HDR_LEN_IN_BYTES(b->sack.hdr.tcp_hlen);
 }
 
+/**
+ * tcp_wnd_shift() - window scale needed to advertise TCP_RCV_WND
+ *
+ * Return: smallest shift that fits the receive window into 16 bits
+ */
+static u8 tcp_wnd_shift(void)
+{
+	u8 shift = 0;
+
+	while ((TCP_RCV_WND >> shift) > 0xffff && shift < TCP_MAX_SCALE)
+		shift++;
+
+	return shift;
+}
+
 /**
  * net_set_ack_options() - set TCP options in SYN packets
  * @b: the packet
@@ -212,6 +237,7 @@ void net_set_syn_options(union tcp_build_pkt *b)
 {
 	if (IS_ENABLED(CONFIG_PROT_TCP_SACK))
 		tcp_lost.len = 0;
+	tcp_rcv_wscale = 0;
 
 	b->ip.hdr.tcp_hlen = 0xa0;
 
@@ -219,7 +245,7 @@ void net_set_syn_options(union tcp_build_pkt *b)
 	b->ip.mss.len = TCP_OPT_LEN_4;
 	b->ip.mss.mss = htons(TCP_MSS);
 	b->ip.scale.kind = TCP_O_SCL;
-	b->ip.scale.scale = TCP_SCALE;
+	b->ip.scale.scale = tcp_wnd_shift();
 	b->ip.scale.len = TCP_OPT_LEN_3;
 	if (IS_ENABLED(CONFIG_PROT_TCP_SACK)) {
 		b->ip.sack_p.kind = TCP_P_SACK;
@@ -334,8 +360,17 @@ int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 	 * SOCs is may not be considered a constraint to buffer space, if
 	 * it is, then the u-boot tftp or nfs kernel netboot should be
 	 * considered.
+	 *
+	 * Payload is stored straight into the load area, so the window is
+	 * not bounded by packet buffers but by how large a burst the network
+	 * driver can absorb, see CONFIG_PROT_TCP_WINDOW. The window in a SYN
+	 * is never scaled; afterwards it is only if the server agreed.
 	 */
-	b->ip.hdr.tcp_win = htons(PKTBUFSRX * TCP_MSS >> TCP_SCALE);
+	b->ip.hdr.tcp_win = htons(min(TCP_RCV_WND >> tcp_rcv_wscale, 0xffff));
+	if (b->ip.hdr.tcp_flags & TCP_ACK) {
+		tcp_unacked = 0;
+		tcp_ack_now = false;
+	}
 
 	b->ip.hdr.tcp_xsum = 0;
 	b->ip.hdr.tcp_ugr = 0;
@@ -349,113 +384,133 @@ int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 	return pkt_hdr_len;
 }
 
+/**
+ * tcp_ooo_insert() - record an out-of-order segment
+ * @l: left edge of the segment
+ * @r: right edge of the segment
+ *
+ * Merges the segment with any range it overlaps or touches. If the table
+ * is full the rightmost range is forgotten: its data is already stored,
+ * the server simply retransmits it as it was never acknowledged.
+ */
+static void tcp_ooo_insert(u32 l, u32 r)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < tcp_ooo_cnt && SEQ_LT(tcp_ooo[i].r, l); i++)
+		;
+	for (j = i; j < tcp_ooo_cnt && !SEQ_GT(tcp_ooo[j].l, r); j++) {
+		if (SEQ_LT(tcp_ooo[j].l, l))
+			l = tcp_ooo[j].l;
+		if (SEQ_GT(tcp_ooo[j].r, r))
+			r = tcp_ooo[j].r;
+	}
+
+	if (i == j) {
+		if (tcp_ooo_cnt == TCP_SACK) {
+			if (i == TCP_SACK) {
+				tcp_ooo_last = TCP_SACK;
+				return;
+			}
+			tcp_ooo_cnt--;
+		}
+		memmove(&tcp_ooo[i + 1], &tcp_ooo[i],
+			(tcp_ooo_cnt - i) * sizeof(*tcp_ooo));
+		tcp_ooo_cnt++;
+	} else {
+		memmove(&tcp_ooo[i + 1], &tcp_ooo[j],
+			(tcp_ooo_cnt - j) * sizeof(*tcp_ooo));
+		tcp_ooo_cnt -= j - i - 1;
+	}
+	tcp_ooo[i].l = l;
+	tcp_ooo[i].r = r;
+	tcp_ooo_last = i;
+}
+
+/**
+ * tcp_sack_update() - rebuild the SACK blocks from the out-of-order ranges
+ *
+ * The first block reports the range holding the most recently received
+ * segment, as RFC 2018 asks, followed by the lowest other ranges.
+ */
+static void tcp_sack_update(void)
+{
+	unsigned int i, n = 0;
+
+	if (tcp_ooo_last < tcp_ooo_cnt)
+		tcp_lost.hill[n++] = tcp_ooo[tcp_ooo_last];
+	for (i = 0; i < tcp_ooo_cnt && n < TCP_SACK_HILLS - 1; i++)
+		if (i != tcp_ooo_last)
+			tcp_lost.hill[n++] = tcp_ooo[i];
+
+	tcp_lost.len = TCP_OPT_LEN_2 + n * TCP_OPT_LEN_8;
+}
+
 /**
  * tcp_hole() - Selective Acknowledgment (Essential for fast stream transfer)
  * @tcp_seq_num: TCP sequence start number
  * @len: the length of sequence numbers
  * @tcp_seq_max: maximum of sequence numbers
+ *
+ * Advances tcp_ack_edge over in-order data and any out-of-order ranges it
+ * now reaches, records segments beyond a hole, and decides whether the
+ * segment has to be acknowledged at once.
  */
 void tcp_hole(u32 tcp_seq_num, u32 len, u32 tcp_seq_max)
 {
-	u32 idx_sack, sack_in;
-	u32 sack_end = TCP_SACK - 1;
-	u32 hill = 0;
-	enum pkt_state expect = PKT;
-	u32 seq = tcp_seq_num - tcp_seq_init;
-	u32 hol_l = tcp_ack_edge - tcp_seq_init;
-	u32 hol_r = 0;
-
-	/* Place new seq number in correct place in receive array */
-	if (prev_len == 0)
-		prev_len = len;
-
-	idx_sack = sack_idx + ((tcp_seq_num - tcp_ack_edge) / prev_len);
-	if (idx_sack < TCP_SACK) {
-		edge_a[idx_sack].se.l = tcp_seq_num;
-		edge_a[idx_sack].se.r = tcp_seq_num + len;
-		edge_a[idx_sack].st = PKT;
+	u32 l = tcp_seq_num;
+	u32 r = tcp_seq_num + len;
+	unsigned int i;
 
-		/*
-		 * The fin (last) packet is not the same length as data
-		 * packets, and if it's length is recorded and used for
-		 *  array index calculation, calculation breaks.
-		 */
-		if (prev_len < len)
-			prev_len = len;
+	if (len > tcp_rcv_mss)
+		tcp_rcv_mss = len;
+
+	debug_cond(DEBUG_DEV_PKT, "TCP hole seq %d, edg %d, len %d, ooo %d\n",
+		   l - tcp_seq_init, tcp_ack_edge - tcp_seq_init, len,
+		   tcp_ooo_cnt);
+
+	if (!SEQ_GT(r, tcp_ack_edge)) {
+		/* Retransmission of acknowledged data: our ACK was lost */
+		tcp_ack_now = true;
+		return;
 	}
 
-	debug_cond(DEBUG_DEV_PKT,
-		   "TCP 1 seq %d, edg %d, len %d, sack_idx %d, sack_end %d\n",
-		    seq, hol_l, len, sack_idx, sack_end);
+	if (SEQ_GT(l, tcp_ack_edge)) {
+		tcp_ooo_insert(l, r);
+		tcp_ack_now = true;
+	} else {
+		tcp_ack_edge = r;
+		for (i = 0; i < tcp_ooo_cnt &&
+		     !SEQ_GT(tcp_ooo[i].l, tcp_ack_edge); i++)
+			if (SEQ_GT(tcp_ooo[i].r, tcp_ack_edge))
+				tcp_ack_edge = tcp_ooo[i].r;
+
+		if (i) {
+			/* A hole was filled, tell the server right away */
+			tcp_ooo_cnt -= i;
+			memmove(tcp_ooo, &tcp_ooo[i],
+				tcp_ooo_cnt * sizeof(*tcp_ooo));
+			tcp_ack_now = true;
+		}
+		tcp_ooo_last = TCP_SACK;
 
-	/* Right edge of contiguous stream, is the left edge of first hill */
-	hol_l = tcp_seq_num - tcp_seq_init;
-	hol_r = hol_l + len;
+		if (++tcp_unacked >= TCP_ACK_SEGS || len < tcp_rcv_mss ||
+		    tcp_ooo_cnt)
+			tcp_ack_now = true;
+	}
 
 	if (IS_ENABLED(CONFIG_PROT_TCP_SACK))
-		tcp_lost.len = TCP_OPT_LEN_2;
+		tcp_sack_update();
+}
 
-	debug_cond(DEBUG_DEV_PKT,
-		   "TCP 1 in %d, seq %d, pkt_l %d, pkt_r %d, sack_idx %d, sack_end %d\n",
-		   idx_sack, seq, hol_l, hol_r, sack_idx, sack_end);
-
-	for (sack_in = sack_idx; sack_in < sack_end && hill < TCP_SACK_HILLS;
-	     sack_in++)  {
-		switch (expect) {
-		case NOPKT:
-			switch (edge_a[sack_in].st) {
-			case NOPKT:
-				debug_cond(DEBUG_INT_STATE, "N");
-				break;
-			case PKT:
-				debug_cond(DEBUG_INT_STATE, "n");
-				if (IS_ENABLED(CONFIG_PROT_TCP_SACK)) {
-					tcp_lost.hill[hill].l =
-						edge_a[sack_in].se.l;
-					tcp_lost.hill[hill].r =
-						edge_a[sack_in].se.r;
-				}
-				expect = PKT;
-				break;
-			}
-			break;
-		case PKT:
-			switch (edge_a[sack_in].st) {
-			case NOPKT:
-				debug_cond(DEBUG_INT_STATE, "p");
-				if (sack_in > sack_idx &&
-				    hill < TCP_SACK_HILLS) {
-					hill++;
-					if (IS_ENABLED(CONFIG_PROT_TCP_SACK))
-						tcp_lost.len += TCP_OPT_LEN_8;
-				}
-				expect = NOPKT;
-				break;
-			case PKT:
-				debug_cond(DEBUG_INT_STATE, "P");
-
-				if (tcp_ack_edge == edge_a[sack_in].se.l) {
-					tcp_ack_edge = edge_a[sack_in].se.r;
-					edge_a[sack_in].st = NOPKT;
-					sack_idx++;
-				} else {
-					if (IS_ENABLED(CONFIG_PROT_TCP_SACK) &&
-					    hill < TCP_SACK_HILLS)
-						tcp_lost.hill[hill].r =
-							edge_a[sack_in].se.r;
-				if (IS_ENABLED(CONFIG_PROT_TCP_SACK) &&
-				    sack_in == sack_end - 1)
-					tcp_lost.hill[hill].r =
-						edge_a[sack_in].se.r;
-				}
-				break;
-			}
-			break;
-		}
-	}
-	debug_cond(DEBUG_INT_STATE, "\n");
-	if (!IS_ENABLED(CONFIG_PROT_TCP_SACK) || tcp_lost.len <= TCP_OPT_LEN_2)
-		sack_idx = 0;
+/**
+ * tcp_ack_due() - check whether received data must be acknowledged now
+ *
+ * Return: true if an ACK should be sent now, false if it may be delayed
+ */
+bool tcp_ack_due(void)
+{
+	return tcp_ack_now;
 }
 
 /**
@@ -466,33 +521,35 @@ void tcp_hole(u32 tcp_seq_num, u32 len, u32 tcp_seq_max)
 void tcp_parse_options(uchar *o, int o_len)
 {
 	struct tcp_t_opt  *tsopt;
+	uchar *end = o + o_len;
 	uchar *p = o;
 
 	/*
-	 * NOPs are options with a zero length, and thus are special.
-	 * All other options have length fields.
+	 * NOPs are single byte options without a length, and thus are
+	 * special. All other options have length fields.
 	 */
-	for (p = o; p < (o + o_len); p = p + p[1]) {
-		if (!p[1])
-			return; /* Finished processing options */
+	while (p < end) {
+		if (p[0] == TCP_O_END)
+			return;
+		if (p[0] == TCP_1_NOP) {
+			p++;
+			continue;
+		}
+		if (p + 1 >= end || p[1] < TCP_OPT_LEN_2 || p + p[1] > end)
+			return; /* Malformed option list */
 
 		switch (p[0]) {
-		case TCP_O_END:
-			return;
-		case TCP_O_MSS:
 		case TCP_O_SCL:
-		case TCP_P_SACK:
-		case TCP_V_SACK:
+			/* Only a SYN may carry it; scale if both sides do */
+			if (current_tcp_state == TCP_SYN_SENT)
+				tcp_rcv_wscale = tcp_wnd_shift();
 			break;
 		case TCP_O_TS:
 			tsopt = (struct tcp_t_opt *)p;
 			rmt_timestamp = tsopt->t_snd;
-			return;
+			break;
 		}
-
-		/* Process optional NOPs */
-		if (p[0] == TCP_O_NOP)
-			p++;
+		p += p[1];
 	}
 }
 
@@ -504,7 +561,6 @@ static u8 tcp_state_machine(u8 tcp_flags, u32 *tcp_seq_num, int payload_len)
 	u8 tcp_push = tcp_flags & TCP_PUSH;
 	u8 tcp_ack = tcp_flags & TCP_ACK;
 	u8 action = TCP_DATA;
-	int i;
 
 	/*
 	 * tcp_flags are examined to determine TX action in a given state
@@ -548,13 +604,12 @@ static u8 tcp_state_machine(u8 tcp_flags, u32 *tcp_seq_num, int payload_len)
 				*tcp_seq_num = *tcp_seq_num + 1;
 				tcp_seq_max = *tcp_seq_num;
 				tcp_ack_edge = *tcp_seq_num;
-				sack_idx = 0;
-				edge_a[sack_idx].se.l = *tcp_seq_num;
-				edge_a[sack_idx].se.r = *tcp_seq_num;
-				prev_len = 0;
+				tcp_ooo_cnt = 0;
+				tcp_ooo_last = TCP_SACK;
+				tcp_unacked = 0;
+				tcp_rcv_mss = 0;
+				tcp_fin_seen = false;
 				current_tcp_state = TCP_ESTABLISHED;
-				for (i = 0; i < TCP_SACK; i++)
-					edge_a[i].st = NOPKT;
 			}
 		} else if (tcp_ack) {
 			action = TCP_DATA;
@@ -565,16 +620,25 @@ static u8 tcp_state_machine(u8 tcp_flags, u32 *tcp_seq_num, int payload_len)
 		debug_cond(DEBUG_INT_STATE, "TCP_ESTABLISHED %x\n", tcp_flags);
 		if (*tcp_seq_num > tcp_seq_max)
 			tcp_seq_max = *tcp_seq_num;
-		if (payload_len > 0) {
+		if (payload_len > 0)
 			tcp_hole(*tcp_seq_num, payload_len, tcp_seq_max);
-			tcp_fin = TCP_DATA;  /* cause standalone FIN */
+		if (tcp_fin) {
+			/* The FIN comes after the payload of its segment */
+			tcp_fin_seq = *tcp_seq_num + payload_len;
+			tcp_fin_seen = true;
 		}
 
-		if ((tcp_fin) &&
-		    (!IS_ENABLED(CONFIG_PROT_TCP_SACK) ||
-		     tcp_lost.len <= TCP_OPT_LEN_2)) {
+		/*
+		 * Only close once all data before the FIN has arrived, which
+		 * may be when a retransmission fills the last hole
+		 */
+		if (tcp_fin_seen && tcp_fin_seq == tcp_ack_edge) {
 			action = action | TCP_FIN | TCP_PUSH | TCP_ACK;
 			current_tcp_state = TCP_CLOSE_WAIT;
+		} else if (tcp_fin) {
+			/* Data before the FIN was lost: ask for it again */
+			action = TCP_ACK;
+			tcp_ack_now = true;
 		} else if (tcp_ack) {
 			action = TCP_DATA;
 		}
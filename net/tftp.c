@@ -10,12 +10,14 @@
 #include <display_options.h>
 #include <efi_loader.h>
 #include <env.h>
+#include <hash.h>
 #include <image.h>
 #include <lmb.h>
 #include <log.h>
 #include <mapmem.h>
 #include <net.h>
 #include <net6.h>
+#include <unzip_load.h>
 #include <asm/global_data.h>
 #include <net/tftp.h>
 #include "bootp.h"
@@ -152,6 +154,33 @@ static char tftp_filename[MAX_LEN];
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = CONFIG_TFTP_BLOCKSIZE;
 static unsigned short tftp_window_size_option = TFTP_WINDOWSIZE;
+/* Set if the block size was chosen with the tftpblocksize variable */
+static bool tftp_block_size_env;
+
+/*
+ * With CONFIG_TFTP_ADAPTIVE the retransmission timeout follows the measured
+ * round-trip time (as in RFC 6298) once data is flowing, and the window size
+ * requested for the next transfer grows or shrinks with the loss seen in the
+ * last one. The server only honours a window size at negotiation time, so it
+ * cannot be changed in the middle of a transfer.
+ */
+#define TFTP_RTO_MIN	100UL
+/* Smoothed round-trip time, times 8 */
+static ulong tftp_srtt;
+/* Round-trip time variation, times 4 */
+static ulong tftp_rttvar;
+static bool tftp_rtt_valid;
+/* Current retransmission timeout */
+static ulong tftp_rto;
+/* When the last window was acknowledged, if that ACK is being timed */
+static ulong tftp_ack_time;
+static bool tftp_ack_timed;
+/* Windows lost (timeouts and out-of-order blocks) in this transfer */
+static uint tftp_lost;
+/* Window size to ask for, 0 until the first transfer */
+static ushort tftp_window_size_adapt;
+/* Window size requested in this transfer */
+static ushort tftp_window_size_req;
 
 static inline int store_block(int block, uchar *src, unsigned int len)
 {
@@ -177,6 +206,8 @@ static inline int store_block(int block, uchar *src, unsigned int len)
 	ptr = map_sysmem(store_addr, len);
 	memcpy(ptr, src, len);
 	unmap_sysmem(ptr);
+	hash_load_update(offset, src, len);
+	unzip_load_update(offset, len);
 
 	if (net_boot_file_size < newsize)
 		net_boot_file_size = newsize;
@@ -222,6 +253,74 @@ static int load_block(unsigned block, uchar *dst, unsigned len)
 static void tftp_send(void);
 static void tftp_timeout_handler(void);
 
+/* Timeout to wait for the next data block */
+static ulong tftp_data_timeout(void)
+{
+	if (IS_ENABLED(CONFIG_TFTP_ADAPTIVE) && tftp_rtt_valid)
+		return tftp_rto;
+
+	return timeout_ms;
+}
+
+/* Send the ACK closing a window and time how long the next block takes */
+static void tftp_send_window_ack(void)
+{
+	tftp_send();
+	tftp_ack_time = get_timer(0);
+	tftp_ack_timed = true;
+}
+
+static void tftp_rtt_sample(void)
+{
+	long err;
+	ulong rtt;
+
+	if (!IS_ENABLED(CONFIG_TFTP_ADAPTIVE) || !tftp_ack_timed)
+		return;
+
+	rtt = get_timer(tftp_ack_time);
+	tftp_ack_timed = false;
+
+	if (!tftp_rtt_valid) {
+		tftp_srtt = rtt << 3;
+		tftp_rttvar = rtt << 1;
+		tftp_rtt_valid = true;
+	} else {
+		err = rtt - (tftp_srtt >> 3);
+		tftp_srtt += err;
+		if (err < 0)
+			err = -err;
+		tftp_rttvar += err - (tftp_rttvar >> 2);
+	}
+
+	tftp_rto = clamp((tftp_srtt >> 3) + tftp_rttvar, TFTP_RTO_MIN,
+			 timeout_ms);
+}
+
+/* A window had to be sent again; do not time the ACK that triggers it */
+static void tftp_window_lost(void)
+{
+	tftp_lost++;
+	tftp_ack_timed = false;
+}
+
+/*
+ * Pick the window size for the next transfer: double it after a transfer
+ * without loss, halve it when more than about 1% of the data was resent.
+ */
+static void tftp_adapt_window(void)
+{
+	ulong blocks = tftp_cur_block + tftp_block_wrap * TFTP_SEQUENCE_SIZE;
+	uint window = max_t(uint, tftp_windowsize, 1);
+
+	if (!tftp_lost)
+		window = min_t(uint, window * 2, tftp_window_size_option);
+	else if ((ulong)tftp_lost * window * 100 > blocks)
+		window = max(window / 2, 1U);
+
+	tftp_window_size_adapt = window;
+}
+
 /**********************************************************************/
 
 static void show_block_marker(void)
@@ -301,6 +400,12 @@ static void tftp_complete(void)
 		print_size(net_boot_file_size /
 			time_start * 1000, "/s");
 	}
+	if (IS_ENABLED(CONFIG_TFTP_ADAPTIVE) && !tftp_put_active) {
+		printf("\n\t window %u, block size %u, rtt %lu ms, %u lost",
+		       tftp_windowsize, tftp_block_size,
+		       tftp_rtt_valid ? tftp_srtt >> 3 : 0UL, tftp_lost);
+		tftp_adapt_window();
+	}
 	puts("\ndone\n");
 	if (IS_ENABLED(CONFIG_CMD_BOOTEFI)) {
 		if (!tftp_put_active)
@@ -362,9 +467,9 @@ static void tftp_send(void)
 		 * Implemented only for tftp get.
 		 * Don't bother sending if it's 1
 		 */
-		if (tftp_state == STATE_SEND_RRQ && tftp_window_size_option > 1)
+		if (tftp_state == STATE_SEND_RRQ && tftp_window_size_req > 1)
 			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
-					0, tftp_window_size_option, 0);
+					0, tftp_window_size_req, 0);
 		len = pkt - xp;
 		break;
 
@@ -581,7 +686,11 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			tftp_cur_block++;
 		}
 #endif
-		tftp_send(); /* Send ACK or first data block */
+		/* Send ACK or first data block */
+		if (tftp_put_active)
+			tftp_send();
+		else
+			tftp_send_window_ack();
 		break;
 	case TFTP_DATA:
 		if (len < 2)
@@ -607,6 +716,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			 * This just overwellms the server, let's just send one.
 			 */
 			if (tftp_last_nack != tftp_cur_block) {
+				tftp_window_lost();
 				tftp_send();
 				tftp_last_nack = tftp_cur_block;
 				tftp_next_ack = (ushort)(tftp_cur_block +
@@ -645,10 +755,12 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			break;
 		}
 
+		tftp_rtt_sample();
 		update_block_number();
 		tftp_prev_block = tftp_cur_block;
 		timeout_count_max = tftp_timeout_count_max;
-		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+		net_set_timeout_handler(tftp_data_timeout(),
+					tftp_timeout_handler);
 
 		if (store_block(tftp_cur_block, pkt + 2, len)) {
 			eth_halt();
@@ -667,7 +779,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		 *	the remote for the next one.
 		 */
 		if (tftp_cur_block == tftp_next_ack) {
-			tftp_send();
+			tftp_send_window_ack();
 			tftp_next_ack += tftp_windowsize;
 		}
 		break;
@@ -700,6 +812,22 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 static void tftp_timeout_handler(void)
 {
+	/*
+	 * While the adaptive timeout is below the configured one, back off
+	 * without counting the timeout against tftptimeoutcountmax
+	 */
+	if (IS_ENABLED(CONFIG_TFTP_ADAPTIVE) && tftp_state == STATE_DATA &&
+	    tftp_rtt_valid && tftp_rto < timeout_ms) {
+		tftp_window_lost();
+		tftp_rto = min(tftp_rto * 2, timeout_ms);
+		puts("T ");
+		net_set_timeout_handler(tftp_rto, tftp_timeout_handler);
+		tftp_send();
+		return;
+	}
+
+	if (tftp_state == STATE_DATA)
+		tftp_window_lost();
 	if (++timeout_count > timeout_count_max) {
 		restart("Retry count exceeded");
 	} else {
@@ -765,6 +893,11 @@ static void sanitize_tftp_block_size_option(enum proto_t protocol)
 		       cap, tftp_block_size_option);
 		saved_tftp_block_size_option = tftp_block_size_option;
 		tftp_block_size_option = cap;
+	} else if (IS_ENABLED(CONFIG_TFTP_ADAPTIVE) && !tftp_block_size_env &&
+		   tftp_block_size_option < cap) {
+		/* Ask for the largest block the link can take */
+		saved_tftp_block_size_option = tftp_block_size_option;
+		tftp_block_size_option = cap;
 	}
 }
 
@@ -785,6 +918,7 @@ void tftp_start(enum proto_t protocol)
 		 */
 
 		ep = env_get("tftpblocksize");
+		tftp_block_size_env = ep != NULL;
 		if (ep != NULL)
 			tftp_block_size_option = simple_strtol(ep, NULL, 10);
 
@@ -815,8 +949,13 @@ void tftp_start(enum proto_t protocol)
 
 	sanitize_tftp_block_size_option(protocol);
 
+	tftp_window_size_req = tftp_window_size_option;
+	if (IS_ENABLED(CONFIG_TFTP_ADAPTIVE) && tftp_window_size_adapt &&
+	    tftp_window_size_adapt < tftp_window_size_option)
+		tftp_window_size_req = tftp_window_size_adapt;
+
 	debug("TFTP blocksize = %i, TFTP windowsize = %d timeout = %ld ms\n",
-	      tftp_block_size_option, tftp_window_size_option, timeout_ms);
+	      tftp_block_size_option, tftp_window_size_req, timeout_ms);
 
 	if (IS_ENABLED(CONFIG_IPV6))
 		tftp_remote_ip6 = net_server_ip6;
@@ -919,6 +1058,8 @@ void tftp_start(enum proto_t protocol)
 		}
 		printf("Load address: 0x%lx\n", tftp_load_addr);
 		puts("Loading: *\b");
+		hash_load_start(tftp_load_addr);
+		unzip_load_start(tftp_load_addr);
 		tftp_state = STATE_SEND_RRQ;
 	}
 
@@ -946,6 +1087,10 @@ void tftp_start(enum proto_t protocol)
 	tftp_cur_block = 0;
 	tftp_windowsize = 1;
 	tftp_last_nack = 0;
+	tftp_rtt_valid = false;
+	tftp_ack_timed = false;
+	tftp_rto = timeout_ms;
+	tftp_lost = 0;
 	/* zero out server ether in case the server ip has changed */
 	memset(net_server_ethaddr, 0, 6);
 	/* Revert tftp_block_size to dflt */
@@ -986,6 +1131,8 @@ void tftp_start_server(void)
 	tftp_our_port = WELL_KNOWN_PORT;
 	tftp_windowsize = 1;
 	tftp_next_ack = tftp_windowsize;
+	tftp_rtt_valid = false;
+	tftp_ack_timed = false;
 
 #ifdef CONFIG_TFTP_TSIZE
 	tftp_tsize = 0;
@@ -8,9 +8,11 @@
 #include <common.h>
 #include <display_options.h>
 #include <env.h>
+#include <hash.h>
 #include <image.h>
 #include <mapmem.h>
 #include <net.h>
+#include <unzip_load.h>
 #include <net/tcp.h>
 #include <net/wget.h>
 
@@ -69,6 +71,8 @@ static inline int store_block(uchar *src, unsigned int offset, unsigned int len)
 	ptr = map_sysmem(image_load_addr + offset, len);
 	memcpy(ptr, src, len);
 	unmap_sysmem(ptr);
+	hash_load_update(offset, src, len);
+	unzip_load_update(offset, len);
 
 	if (net_boot_file_size < (offset + len))
 		net_boot_file_size = newsize;
@@ -174,6 +178,16 @@ static void wget_timeout_handler(void)
 	}
 }
 
+/*
+ * Delayed ACK timer: no data arrived since the last segment, so
+ * acknowledge it now and fall back to the transfer timeout.
+ */
+static void wget_delack_handler(void)
+{
+	net_set_timeout_handler(wget_timeout, wget_timeout_handler);
+	wget_send_stored();
+}
+
 #define PKT_QUEUE_OFFSET 0x20000
 #define PKT_QUEUE_PACKET_SIZE 0x800
 
@@ -344,8 +358,17 @@ static void wget_handler(uchar *pkt, unsigned int tcp_seq_num,
 			net_set_state(NETLOOP_FAIL);
 			break;
 		case TCP_ESTABLISHED:
-			wget_send(TCP_ACK, tcp_seq_num, tcp_ack_num,
-				  len);
+			if (tcp_ack_due()) {
+				wget_send(TCP_ACK, tcp_seq_num, tcp_ack_num,
+					  len);
+			} else {
+				retry_action = TCP_ACK;
+				retry_tcp_ack_num = tcp_seq_num;
+				retry_tcp_seq_num = tcp_ack_num;
+				retry_len = len;
+				net_set_timeout_handler(TCP_DELACK_TIMEOUT,
+							wget_delack_handler);
+			}
 			wget_loop_state = NETLOOP_SUCCESS;
 			break;
 		case TCP_CLOSE_WAIT:     /* End of transfer */
@@ -418,6 +441,8 @@ void wget_start(void)
 	}
 	debug_cond(DEBUG_WGET,
 		   "\nwget:Load address: 0x%lx\nLoading: *\b", image_load_addr);
+	hash_load_start(image_load_addr);
+	unzip_load_start(image_load_addr);
 
 	net_set_timeout_handler(wget_timeout, wget_timeout_handler);
 	tcp_set_tcp_handler(wget_handler);
@@ -8,10 +8,15 @@
 
 #include <common.h>
 #include <image.h>
+#include <asm/global_data.h>
+#include <linux/libfdt.h>
 #include <test/suites.h>
 #include <test/ut.h>
+#include <u-boot/rsa.h>
 #include "bootstd_common.h"
 
+DECLARE_GLOBAL_DATA_PTR;
+
 /* Test of image phase */
 static int test_image_phase(struct unit_test_state *uts)
 {
@@ -34,3 +39,56 @@ static int test_image_phase(struct unit_test_state *uts)
 	return 0;
 }
 BOOTSTD_TEST(test_image_phase, 0);
+
+/* Test that image data is hashed only once when verifying a FIT image */
+static int test_image_fit_digest(struct unit_test_state *uts)
+{
+	u8 value[FIT_MAX_HASH_LEN], sig[RSA2048_BYTES];
+	char fit[1024], data[256];
+	int images, image, node;
+	int i, len, calcs, hits;
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = i;
+	ut_assertok(calculate_hash(data, sizeof(data), "sha256", value, &len));
+
+	ut_assertok(fdt_create_empty_tree(fit, sizeof(fit)));
+	images = fdt_add_subnode(fit, 0, FIT_IMAGES_PATH + 1);
+	ut_assert(images >= 0);
+	image = fdt_add_subnode(fit, images, "kernel");
+	ut_assert(image >= 0);
+
+	node = fdt_add_subnode(fit, image, FIT_HASH_NODENAME "-1");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_string(fit, node, FIT_ALGO_PROP, "sha256"));
+	ut_assertok(fdt_setprop(fit, node, FIT_VALUE_PROP, value, len));
+
+	/* a signature using the same algorithm, with no key to check it */
+	node = fdt_add_subnode(fit, image, FIT_SIG_NODENAME "-1");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_string(fit, node, FIT_ALGO_PROP,
+				       "sha256,rsa2048"));
+	ut_assertok(fdt_setprop_string(fit, node, FIT_KEY_HINT, "none"));
+	memset(sig, '\0', sizeof(sig));
+	ut_assertok(fdt_setprop(fit, node, FIT_VALUE_PROP, sig, sizeof(sig)));
+
+	/* the hash and signature nodes share a single digest */
+	calcs = fit_digest_calc_count();
+	hits = fit_digest_hit_count();
+	ut_asserteq(1, fit_image_verify_with_data(fit, image, gd_fdt_blob(),
+						  data, sizeof(data)));
+	ut_asserteq(calcs + 1, fit_digest_calc_count());
+	ut_asserteq(hits + 1, fit_digest_hit_count());
+
+	/* the digest is dropped afterwards, so a change to the data is seen */
+	ut_assert(!fit_digest_lookup("sha256", data, sizeof(data), value,
+				     &len));
+	data[0]++;
+	ut_asserteq(0, fit_image_verify_with_data(fit, image, gd_fdt_blob(),
+						  data, sizeof(data)));
+	ut_asserteq(calcs + 2, fit_digest_calc_count());
+	ut_asserteq(hits + 2, fit_digest_hit_count());
+
+	return 0;
+}
+BOOTSTD_TEST(test_image_fit_digest, 0);
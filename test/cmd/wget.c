@@ -204,3 +204,33 @@ static int net_test_wget(struct unit_test_state *uts)
 }
 
 LIB_TEST(net_test_wget, 0);
+
+#if CONFIG_IS_ENABLED(HASH_LOAD)
+/* Test hashing the file while it is loaded */
+static int net_test_wget_hash(struct unit_test_state *uts)
+{
+	sandbox_eth_set_tx_handler(0, sb_http_handler);
+	sandbox_eth_set_priv(0, uts);
+
+	env_set("ethact", "eth@10002000");
+	env_set("ethrotate", "no");
+	env_set("loadaddr", "0x20000");
+	env_set("loadhash", "sha256");
+	env_set("filehash", "stale");
+	ut_assertok(run_command("wget ${loadaddr} 1.1.2.2:/index.html", 0));
+	env_set("loadhash", NULL);
+
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	ut_assertok(console_record_reset_enable());
+	run_command("hash sha256 ${loadaddr} ${filesize} expect", 0);
+	ut_assertnonnull(env_get("filehash"));
+	ut_asserteq_str(env_get("expect"), env_get("filehash"));
+	env_set("filehash", NULL);
+	env_set("expect", NULL);
+
+	return 0;
+}
+
+LIB_TEST(net_test_wget_hash, 0);
+#endif
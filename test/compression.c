@@ -7,11 +7,13 @@
 #include <abuf.h>
 #include <bootm.h>
 #include <command.h>
+#include <env.h>
 #include <gzip.h>
 #include <image.h>
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <unzip_load.h>
 #include <asm/io.h>
 
 #include <u-boot/lz4.h>
@@ -475,6 +477,42 @@ static int compression_test_gzip(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_gzip, 0);
 
+/* Check matches which overlap themselves, copied by the inflate fast path */
+static int compression_test_gzip_matches(struct unit_test_state *uts)
+{
+	const ulong size = 0x2000;
+	ulong comp_size, out_size;
+	char *buf, *comp, *out;
+	uint period, i, pos;
+
+	buf = malloc(size);
+	comp = malloc(size);
+	out = malloc(size);
+	ut_assertnonnull(buf);
+	ut_assertnonnull(comp);
+	ut_assertnonnull(out);
+
+	/* runs of 300 bytes repeating every 1 to 24 bytes */
+	for (pos = 0, period = 1; pos < size; period = period % 24 + 1) {
+		for (i = 0; i < 300 && pos < size; i++, pos++)
+			buf[pos] = i < period ? pos * 7 + period : buf[pos - period];
+	}
+	ut_assertok(compress_using_gzip(uts, buf, size, comp, size,
+					&comp_size));
+	ut_assert(comp_size < size / 2);
+	ut_assertok(uncompress_using_gzip(uts, comp, comp_size, out, size,
+					  &out_size));
+	ut_asserteq(size, out_size);
+	ut_asserteq_mem(buf, out, size);
+
+	free(out);
+	free(comp);
+	free(buf);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_gzip_matches, 0);
+
 static int compression_test_bzip2(struct unit_test_state *uts)
 {
 	return run_test(uts, "bzip2", compress_using_bzip2,
@@ -508,6 +546,134 @@ static int compression_test_zstd(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_zstd, 0);
 
+/* Check that data compressed as several frames one after the other works */
+static int run_multi_test(struct unit_test_state *uts, mutate_func compress,
+			  mutate_func uncompress)
+{
+	char in[TEST_BUFFER_SIZE * 2], out[TEST_BUFFER_SIZE * 2];
+	ulong orig_size = strlen(plain);
+	ulong size, out_size;
+
+	ut_assertok(compress(uts, (void *)plain, orig_size, in,
+			     TEST_BUFFER_SIZE, &size));
+	memcpy(in + size, in, size);
+	memset(in + size * 2, 'A', 4);
+
+	ut_assertok(uncompress(uts, in, size * 2 + 4, out, sizeof(out),
+			       &out_size));
+	ut_asserteq(orig_size * 2, out_size);
+	ut_asserteq_mem(plain, out, orig_size);
+	ut_asserteq_mem(plain, out + orig_size, orig_size);
+
+	/* A frame which does not fit is an error, not dropped */
+	ut_assert(uncompress(uts, in, size * 2, out, orig_size, &out_size));
+
+	return 0;
+}
+
+/* Check that junk after gzip data is ignored, even if it looks like gzip */
+static int run_gzip_junk_test(struct unit_test_state *uts)
+{
+	char in[TEST_BUFFER_SIZE], out[TEST_BUFFER_SIZE];
+	ulong orig_size = strlen(plain);
+	ulong size, out_size;
+
+	ut_assertok(compress_using_gzip(uts, (void *)plain, orig_size, in,
+					sizeof(in) - 16, &size));
+	memset(in + size, '\xff', 16);
+	in[size] = 0x1f;
+	in[size + 1] = 0x8b;
+
+	ut_assertok(uncompress_using_gzip(uts, in, size + 16, out, sizeof(out),
+					  &out_size));
+	ut_asserteq(orig_size, out_size);
+	ut_asserteq_mem(plain, out, orig_size);
+
+	/* a valid header followed by data which does not inflate */
+	in[size + 2] = 8;
+	memset(in + size + 3, '\0', 7);
+	ut_assertok(uncompress_using_gzip(uts, in, size + 16, out, sizeof(out),
+					  &out_size));
+	ut_asserteq(orig_size, out_size);
+	ut_asserteq_mem(plain, out, orig_size);
+
+	return 0;
+}
+
+static int compression_test_multi(struct unit_test_state *uts)
+{
+	ut_assertok(run_multi_test(uts, compress_using_gzip,
+				   uncompress_using_gzip));
+	ut_assertok(run_multi_test(uts, compress_using_lz4,
+				   uncompress_using_lz4));
+	ut_assertok(run_multi_test(uts, compress_using_zstd,
+				   uncompress_using_zstd));
+	ut_assertok(run_gzip_junk_test(uts));
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_multi, 0);
+
+#if CONFIG_IS_ENABLED(UNZIP_LOAD)
+/*
+ * Decompress two frames followed by junk, arriving a few bytes at a time, so
+ * that packets end at every position in and just after each frame
+ */
+static int run_unzip_load_test(struct unit_test_state *uts,
+			       mutate_func compress)
+{
+	const ulong load_addr = 0x1000, unzip_addr = 0x10000;
+	ulong orig_size = strlen(plain);
+	ulong size, offset, len, chunk;
+	char *in, *out;
+
+	in = map_sysmem(load_addr, TEST_BUFFER_SIZE * 2);
+	out = map_sysmem(unzip_addr, TEST_BUFFER_SIZE * 2);
+	ut_assertok(compress(uts, (void *)plain, orig_size, in,
+			     TEST_BUFFER_SIZE, &size));
+	memcpy(in + size, in, size);
+	memset(in + size * 2, 'A', 4);
+	size = size * 2 + 4;
+
+	for (chunk = 1; chunk <= 8; chunk++) {
+		memset(out, '\0', orig_size * 2);
+		ut_assertok(unzip_load_start(load_addr));
+		for (offset = 0; offset < size; offset += len) {
+			len = min(size - offset, chunk);
+			unzip_load_update(offset, len);
+			unzip_load_poll();
+		}
+		ut_assertok(unzip_load_finish(size));
+		ut_asserteq(orig_size * 2, env_get_hex("unzipsize", 0));
+		ut_asserteq_mem(plain, out, orig_size);
+		ut_asserteq_mem(plain, out + orig_size, orig_size);
+	}
+
+	/* an uncompressed file is left alone */
+	ut_assertok(unzip_load_start(unzip_addr));
+	unzip_load_update(0, orig_size);
+	unzip_load_poll();
+	ut_assertok(unzip_load_finish(orig_size));
+	ut_assertnull(env_get("unzipsize"));
+
+	unmap_sysmem(out);
+	unmap_sysmem(in);
+
+	return 0;
+}
+
+static int compression_test_unzip_load(struct unit_test_state *uts)
+{
+	env_set_hex("unzipaddr", 0x10000);
+	ut_assertok(run_unzip_load_test(uts, compress_using_gzip));
+	ut_assertok(run_unzip_load_test(uts, compress_using_zstd));
+	env_set("unzipaddr", NULL);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_unzip_load, 0);
+#endif
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
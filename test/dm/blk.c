@@ -337,3 +337,131 @@ static int dm_test_blk_foreach(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_foreach, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+static void blk_test_complete(struct blk_request *req)
+{
+	int *count = req->priv;
+
+	(*count)++;
+}
+
+/* Test queued block I/O requests on a device without native support */
+static int dm_test_blk_submit(struct unit_test_state *uts)
+{
+	char wbuf[3 * 512], rbuf[3 * 512];
+	struct blk_request req;
+	struct blk_sg sg[2];
+	struct udevice *dev;
+	int count = 0;
+
+	ut_assertok(blk_get_device(UCLASS_MMC, 0, &dev));
+	memset(wbuf, 'a', 512);
+	memset(wbuf + 512, 'b', 2 * 512);
+
+	/* write from two segments */
+	sg[0].buf = wbuf;
+	sg[0].blkcnt = 1;
+	sg[1].buf = wbuf + 512;
+	sg[1].blkcnt = 2;
+	memset(&req, '\0', sizeof(req));
+	req.op = BLK_REQ_WRITE;
+	req.start = 10;
+	req.sg = sg;
+	req.sg_count = 2;
+	req.complete = blk_test_complete;
+	req.priv = &count;
+	ut_assertok(blk_submit(dev, &req));
+	ut_assertok(blk_wait(&req));
+	ut_asserteq_ptr(dev, req.dev);
+	ut_asserteq(3, req.blkcnt_done);
+	ut_asserteq(1, count);
+
+	/* read it back into one */
+	sg[0].buf = rbuf;
+	sg[0].blkcnt = 3;
+	req.op = BLK_REQ_READ;
+	req.sg_count = 1;
+	ut_assertok(blk_submit(dev, &req));
+	ut_asserteq(0, blk_poll(dev));
+	ut_assertok(blk_wait(&req));
+	ut_asserteq(3, req.blkcnt_done);
+	ut_asserteq(2, count);
+	ut_asserteq_mem(wbuf, rbuf, sizeof(rbuf));
+	ut_asserteq(3, blk_request_blkcnt(&req));
+
+	return 0;
+}
+DM_TEST(dm_test_blk_submit, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLOCK_CACHE)
+/* Test the block cache lookup, eviction and readahead */
+static int dm_test_blk_cache(struct unit_test_state *uts)
+{
+	struct block_cache_dev_stats dstats;
+	struct block_cache_stats stats;
+	char buf[16 * 512], out[16 * 512];
+	int i;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i / 512;
+
+	blkcache_free();
+	blkcache_configure(8, 2);
+	blkcache_configure_size(2 * 8 * 512, 32);
+
+	/* a fill which straddles two lines can be read back in pieces */
+	blkcache_fill(UCLASS_HOST, 0, 6, 4, 512, buf);
+	ut_asserteq(1, blkcache_read(UCLASS_HOST, 0, 6, 4, 512, out));
+	ut_assertok(memcmp(buf, out, 4 * 512));
+	ut_asserteq(1, blkcache_read(UCLASS_HOST, 0, 8, 2, 512, out));
+	ut_assertok(memcmp(buf + 2 * 512, out, 2 * 512));
+
+	/* blocks which were never filled, or on another device, miss */
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 0, 5, 2, 512, out));
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 1, 6, 4, 512, out));
+
+	/*
+	 * a third line evicts the least recently used one, which is the line
+	 * at block 8 since the lookup for block 5 touched the line at block 0
+	 */
+	blkcache_fill(UCLASS_HOST, 0, 16, 8, 512, buf);
+	ut_asserteq(1, blkcache_read(UCLASS_HOST, 0, 6, 2, 512, out));
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 0, 8, 2, 512, out));
+	ut_asserteq(1, blkcache_read(UCLASS_HOST, 0, 16, 8, 512, out));
+
+	blkcache_stats(&stats);
+	ut_asserteq(4, stats.hits);
+	ut_asserteq(3, stats.misses);
+	ut_asserteq(2, stats.entries);
+	ut_asserteq(2 * 8 * 512, stats.size);
+
+	/* only sequential misses read ahead, and the window then grows */
+	ut_asserteq(1, blkcache_readahead(UCLASS_HOST, 0, 24, 1));
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 0, 24, 1, 512, out));
+	ut_asserteq(8, blkcache_readahead(UCLASS_HOST, 0, 24, 1));
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 0, 25, 1, 512, out));
+	ut_asserteq(15, blkcache_readahead(UCLASS_HOST, 0, 25, 1));
+
+	ut_assertok(blkcache_dev_stats(0, &dstats));
+	ut_asserteq(UCLASS_HOST, dstats.iftype);
+	ut_asserteq(0, dstats.devnum);
+	ut_asserteq(2, dstats.readaheads);
+	ut_assertok(blkcache_dev_stats(1, &dstats));
+	ut_asserteq(1, dstats.devnum);
+	ut_asserteq(-ENOENT, blkcache_dev_stats(2, &dstats));
+
+	/* invalidating one device leaves the others alone */
+	blkcache_fill(UCLASS_HOST, 1, 0, 1, 512, buf);
+	blkcache_invalidate(UCLASS_HOST, 0);
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 0, 8, 2, 512, out));
+	ut_asserteq(1, blkcache_read(UCLASS_HOST, 1, 0, 1, 512, out));
+
+	blkcache_free();
+	blkcache_configure(8, CONFIG_BLOCK_CACHE_SIZE / (8 * 512));
+	blkcache_configure_size(CONFIG_BLOCK_CACHE_SIZE,
+				CONFIG_BLOCK_CACHE_READAHEAD);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache, 0);
+#endif
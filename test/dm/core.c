@@ -1073,6 +1073,69 @@ static int dm_test_uclass_devices_find_by_name(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_uclass_devices_find_by_name, UT_TESTF_SCAN_FDT);
 
+/* Test that lookups by seq and ofnode follow binding and unbinding */
+static int dm_test_uclass_find_after_unbind(struct unit_test_state *uts)
+{
+	struct udevice *dev, *finddev;
+	ofnode node;
+	int seq;
+
+	ut_assertok(uclass_find_first_device(UCLASS_TEST_FDT, &dev));
+	ut_assertnonnull(dev);
+	node = dev_ofnode(dev);
+	seq = dev_seq(dev);
+
+	ut_assertok(uclass_find_device_by_seq(UCLASS_TEST_FDT, seq, &finddev));
+	ut_asserteq_ptr(dev, finddev);
+	ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT, node,
+						 &finddev));
+	ut_asserteq_ptr(dev, finddev);
+
+	/* The same node in another uclass must not match */
+	ut_asserteq(-ENODEV, uclass_find_device_by_ofnode(UCLASS_TEST, node,
+							  &finddev));
+
+	ut_assertok(device_unbind(dev));
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST_FDT, seq,
+						       &finddev));
+	ut_asserteq(-ENODEV, uclass_find_device_by_ofnode(UCLASS_TEST_FDT,
+							  node, &finddev));
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_find_after_unbind, UT_TESTF_SCAN_FDT);
+
+/* Test that lookups follow a change of seq or ofnode after bind */
+static int dm_test_uclass_find_after_set(struct unit_test_state *uts)
+{
+	struct udevice *dev, *finddev;
+	ofnode node, other;
+	int seq;
+
+	ut_assertok(uclass_find_first_device(UCLASS_TEST_FDT, &dev));
+	ut_assertnonnull(dev);
+	node = dev_ofnode(dev);
+	seq = dev_seq(dev);
+
+	device_set_seq(dev, 100);
+	ut_assertok(uclass_find_device_by_seq(UCLASS_TEST_FDT, 100, &finddev));
+	ut_asserteq_ptr(dev, finddev);
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST_FDT, seq,
+						       &finddev));
+
+	other = ofnode_path("/aliases");
+	ut_assert(ofnode_valid(other));
+	device_set_ofnode(dev, other);
+	ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT, other,
+						 &finddev));
+	ut_asserteq_ptr(dev, finddev);
+	ut_asserteq(-ENODEV, uclass_find_device_by_ofnode(UCLASS_TEST_FDT,
+							  node, &finddev));
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_find_after_set, UT_TESTF_SCAN_FDT);
+
 static int dm_test_uclass_devices_get(struct unit_test_state *uts)
 {
 	struct udevice *dev;
@@ -1184,6 +1247,178 @@ static int dm_test_inactive_child(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_inactive_child, UT_TESTF_SCAN_PDATA);
 
+static struct udevice *defer_supplier;
+static int defer_probe_count;
+
+static int test_defer_probe(struct udevice *dev)
+{
+	defer_probe_count++;
+	if (!defer_supplier || !device_active(defer_supplier))
+		return -EPROBE_DEFER;
+
+	return 0;
+}
+
+U_BOOT_DRIVER(test_defer_drv) = {
+	.name	= "test_defer_drv",
+	.id	= UCLASS_TEST,
+	.probe	= test_defer_probe,
+};
+
+static int bind_autoprobe(struct unit_test_state *uts, struct udevice *parent,
+			  const struct driver *drv, const char *name,
+			  struct udevice **devp)
+{
+	ut_assertok(device_bind(parent, drv, name, NULL, ofnode_null(), devp));
+	dev_or_flags(*devp, DM_FLAG_PROBE_AFTER_BIND);
+
+	return 0;
+}
+
+/* Test that devices which defer their probe after bind are retried */
+static int dm_test_autoprobe_defer(struct unit_test_state *uts)
+{
+	struct udevice *dev, *child;
+
+	if (!CONFIG_IS_ENABLED(DM_PROBE_DEFER))
+		return -EAGAIN;
+
+	/* Skip the behaviour in test_post_probe() */
+	uts->skip_post_probe = 1;
+	defer_supplier = NULL;
+	defer_probe_count = 0;
+
+	/* The supplier comes after the device which needs it */
+	ut_assertok(bind_autoprobe(uts, dm_root(),
+				   DM_DRIVER_GET(test_defer_drv), "defer",
+				   &dev));
+	ut_assertok(bind_autoprobe(uts, dev, DM_DRIVER_GET(test_drv),
+				   "defer_child", &child));
+	ut_assertok(bind_autoprobe(uts, dm_root(), DM_DRIVER_GET(test_drv),
+				   "supplier", &defer_supplier));
+
+	ut_assertok(dm_autoprobe(false));
+	ut_assert(device_active(defer_supplier));
+	ut_assert(device_active(dev));
+	ut_assert(device_active(child));
+	ut_assert(!(dev_get_flags(dev) & DM_FLAG_PROBE_DEFERRED));
+	ut_asserteq(2, defer_probe_count);
+
+	/* A device whose supplier never turns up is tried once more */
+	defer_supplier = NULL;
+	defer_probe_count = 0;
+	ut_assertok(bind_autoprobe(uts, dm_root(),
+				   DM_DRIVER_GET(test_defer_drv), "stuck",
+				   &dev));
+	ut_assertok(dm_autoprobe(false));
+	ut_assert(!device_active(dev));
+	ut_assert(dev_get_flags(dev) & DM_FLAG_PROBE_DEFERRED);
+	ut_asserteq(2, defer_probe_count);
+
+	return 0;
+}
+DM_TEST(dm_test_autoprobe_defer, 0);
+
+#if CONFIG_IS_ENABLED(DM_ASYNC_PROBE)
+/**
+ * struct async_plat - Controls a device of test_async_drv
+ *
+ * @settle: Number of calls to probe_complete() before the device is ready
+ * @err: Value for probe_complete() to return once the device is ready
+ * @polls: Number of calls to probe_complete() so far
+ */
+struct async_plat {
+	int settle;
+	int err;
+	int polls;
+};
+
+static int test_async_probe(struct udevice *dev)
+{
+	struct async_plat *plat = dev_get_plat(dev);
+
+	plat->polls = 0;
+
+	return 0;
+}
+
+static int test_async_complete(struct udevice *dev)
+{
+	struct async_plat *plat = dev_get_plat(dev);
+
+	if (++plat->polls < plat->settle)
+		return -EINPROGRESS;
+
+	return plat->err;
+}
+
+U_BOOT_DRIVER(test_async_drv) = {
+	.name	= "test_async_drv",
+	.id	= UCLASS_TEST,
+	.probe	= test_async_probe,
+	.flags	= DM_FLAG_ASYNC_PROBE,
+	DM_PROBE_COMPLETE_PTR(test_async_complete)
+};
+
+/* Test that devices can settle in the background and together */
+static int dm_test_async_probe(struct unit_test_state *uts)
+{
+	struct async_plat plat1 = { .settle = 3 }, plat2 = { .settle = 1000 };
+	struct async_plat plat3 = { .settle = 2, .err = -EIO };
+	struct udevice *dev1, *dev2, *dev3;
+
+	/* Skip the behaviour in test_post_probe() */
+	uts->skip_post_probe = 1;
+
+	ut_assertok(device_bind(dm_root(), DM_DRIVER_GET(test_async_drv),
+				"async1", &plat1, ofnode_null(), &dev1));
+	ut_assertok(device_bind(dm_root(), DM_DRIVER_GET(test_async_drv),
+				"async2", &plat2, ofnode_null(), &dev2));
+	ut_assertok(device_bind(dm_root(), DM_DRIVER_GET(test_async_drv),
+				"async3", &plat3, ofnode_null(), &dev3));
+
+	ut_assertok(device_probe_start(dev1));
+	ut_assertok(device_probe_start(dev2));
+	ut_asserteq(1, plat1.polls);
+	ut_asserteq(1, plat2.polls);
+	ut_assert(dev_get_flags(dev1) & DM_FLAG_PROBE_PENDING);
+	ut_assert(dev_get_flags(dev2) & DM_FLAG_PROBE_PENDING);
+
+	ut_assert(!device_active(dev1));
+	ut_assert(!device_active(dev2));
+
+	/* Waiting for the first device leaves the second one alone */
+	ut_assertok(device_probe(dev1));
+	ut_asserteq(3, plat1.polls);
+	ut_assert(!(dev_get_flags(dev1) & DM_FLAG_PROBE_PENDING));
+	ut_assert(device_active(dev1));
+	ut_asserteq(1, plat2.polls);
+	ut_assert(!device_active(dev2));
+
+	device_probe_wait_all();
+	ut_asserteq(1000, plat2.polls);
+	ut_assert(!(dev_get_flags(dev2) & DM_FLAG_PROBE_PENDING));
+	ut_assert(device_active(dev2));
+
+	/* A device which fails to settle ends up unprobed */
+	ut_assertok(device_probe_start(dev3));
+	ut_assert(dev_get_flags(dev3) & DM_FLAG_PROBE_PENDING);
+	ut_asserteq(-EIO, device_probe(dev3));
+	ut_assert(!device_active(dev3));
+	ut_assert(!(dev_get_flags(dev3) & DM_FLAG_PROBE_PENDING));
+
+	/* Removing a pending device waits for it first */
+	plat3.err = 0;
+	ut_assertok(device_probe_start(dev3));
+	ut_assertok(device_remove(dev3, DM_REMOVE_NORMAL));
+	ut_asserteq(2, plat3.polls);
+	ut_assert(!device_active(dev3));
+
+	return 0;
+}
+DM_TEST(dm_test_async_probe, 0);
+#endif
+
 /* Make sure all bound devices have a sequence number */
 static int dm_test_all_have_seq(struct unit_test_state *uts)
 {
@@ -1353,3 +1588,36 @@ static int dm_test_dev_get_mem(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_dev_get_mem, UT_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(DM_TIMING)
+/* Test recording the time taken to probe a device and its parent */
+static int dm_test_dev_timing(struct unit_test_state *uts)
+{
+	struct udevice *dev, *bus;
+
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST_FDT, "c-test@5",
+					       &dev));
+	bus = dev_get_parent(dev);
+	ut_asserteq_str("some-bus", bus->name);
+	ut_assert(!device_active(dev));
+	ut_assert(!device_active(bus));
+	ut_asserteq(0, dev->probe_start_us);
+
+	/* probing the device probes its parent in the middle */
+	ut_assertok(device_probe(dev));
+	ut_assert(dev->probe_start_us);
+	ut_assert(dev->probe_self_us <= dev->probe_us);
+	ut_assert(bus->probe_start_us >= dev->probe_start_us);
+	ut_assert(bus->probe_start_us + bus->probe_us <=
+		  dev->probe_start_us + dev->probe_us);
+	ut_assert(bus->probe_us <= dev->probe_us - dev->probe_self_us);
+
+	/* a second probe does nothing and so leaves the times alone */
+	bus->probe_us = 12345;
+	ut_assertok(device_probe(bus));
+	ut_asserteq(12345, bus->probe_us);
+
+	return 0;
+}
+DM_TEST(dm_test_dev_timing, UT_TESTF_SCAN_FDT);
+#endif
@@ -189,6 +189,41 @@ static int dm_test_eth(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_eth, UT_TESTF_SCAN_FDT);
 
+/* Test that the receive and transmit paths are accounted for */
+static int dm_test_eth_stats(struct unit_test_state *uts)
+{
+	const struct eth_stats *stats;
+	struct eth_stats before;
+	struct udevice *dev;
+	int i;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_ETH, "eth@10002000",
+					      &dev));
+	stats = eth_get_stats(dev);
+	ut_assertnonnull(stats);
+	before = *stats;
+
+	net_ping_ip = string_to_ip("1.1.2.2");
+	env_set("ethact", "eth@10002000");
+	ut_assertok(net_loop(PING));
+
+	ut_assert(stats->tx_packets > before.tx_packets);
+	ut_assert(stats->rx_packets > before.rx_packets);
+	ut_assert(stats->rx_bytes > before.rx_bytes);
+	ut_assert(stats->rx_polls > before.rx_polls);
+	ut_asserteq(before.rx_errors, stats->rx_errors);
+	ut_asserteq(before.tx_errors, stats->tx_errors);
+
+	/* A frame that does not fit into the receive ring is an overrun */
+	for (i = 0; i < PKTBUFSRX; i++)
+		ut_assertok(sandbox_eth_recv_arp_req(dev));
+	ut_asserteq(-EOVERFLOW, sandbox_eth_recv_arp_req(dev));
+	ut_asserteq(before.rx_overruns + 1, stats->rx_overruns);
+
+	return 0;
+}
+DM_TEST(dm_test_eth_stats, UT_TESTF_SCAN_FDT);
+
 static int dm_test_eth_alias(struct unit_test_state *uts)
 {
 	net_ping_ip = string_to_ip("1.1.2.2");
@@ -148,6 +148,135 @@ static int dm_test_ofnode_get_by_phandle_ot(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_ofnode_get_by_phandle_ot, UT_TESTF_OTHER_FDT);
 
+/* Check that each node below @parent can be found by its path and phandle */
+static int check_node_lookup(struct unit_test_state *uts, ofnode parent)
+{
+	char buf[256];
+	ofnode node;
+	uint phandle;
+
+	ofnode_for_each_subnode(node, parent) {
+		ut_assertok(ofnode_get_path(node, buf, sizeof(buf)));
+		ut_assert(ofnode_equal(node, ofnode_path(buf)));
+		phandle = ofnode_read_u32_default(node, "phandle", 0);
+		if (phandle)
+			ut_assert(ofnode_equal(node,
+					       ofnode_get_by_phandle(phandle)));
+		ut_assertok(check_node_lookup(uts, node));
+	}
+
+	return 0;
+}
+
+static int dm_test_ofnode_lookup_all(struct unit_test_state *uts)
+{
+	ofnode node;
+
+	ut_assertok(check_node_lookup(uts, ofnode_root()));
+
+	/* Adding a node moves the nodes after it in the flat tree */
+	ut_assertok(ofnode_add_subnode(ofnode_root(), "aardvark", &node));
+	ut_assert(ofnode_equal(node, ofnode_path("/aardvark")));
+	ut_assertok(check_node_lookup(uts, ofnode_root()));
+	ut_assert(!ofnode_valid(ofnode_path("/aardvark/none")));
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_lookup_all, UT_TESTF_SCAN_FDT);
+
+/* Check that cached properties stay correct as the flat tree changes */
+static int dm_test_ofnode_prop_cache(struct unit_test_state *uts)
+{
+	struct ofnode_prop_stats before, after;
+	void *fdt = (void *)gd->fdt_blob;
+	bool stats;
+	ofnode node;
+	u32 val;
+
+	/* Adding a property to the root node moves every node after it */
+	node = ofnode_path("/a-test");
+	ut_assertok(ofnode_read_u32(node, "int-value", &val));
+	ut_assertok(fdt_setprop_u32(fdt, 0, "prop-cache-test", 1));
+	node = ofnode_path("/a-test");
+	ut_assert(ofnode_valid(node));
+
+	stats = !ofnode_get_prop_stats(&before);
+	ut_assertok(ofnode_read_u32(node, "int-value", &val));
+	ut_asserteq(1234, val);
+	ut_assertok(ofnode_read_u32(node, "int-value", &val));
+	ut_asserteq(1234, val);
+	ut_asserteq(0x1234, ofnode_read_u16_default(node, "int16-value", 0));
+	ut_asserteq(0x1234, ofnode_read_u16_default(node, "int16-value", 0));
+	ut_assert(!ofnode_read_bool(node, "missing"));
+	if (stats) {
+		ut_assertok(ofnode_get_prop_stats(&after));
+		ut_asserteq(before.lookups + 5, after.lookups);
+		ut_asserteq(before.hits + 2, after.hits);
+	}
+
+	/* Properties which are rewritten in place can be read again */
+	ut_assertok(ofnode_write_u32(node, "int-value", 4321));
+	ut_assertok(ofnode_read_u32(node, "int-value", &val));
+	ut_asserteq(4321, val);
+
+	/* A new property is found */
+	ut_asserteq(-EINVAL, ofnode_read_u32(node, "new-value", &val));
+	ut_assertok(ofnode_write_u32(node, "new-value", 5));
+	ut_assertok(ofnode_read_u32(node, "new-value", &val));
+	ut_asserteq(5, val);
+	ut_assertok(ofnode_read_u32(node, "int-value", &val));
+	ut_asserteq(4321, val);
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_prop_cache, UT_TESTF_SCAN_FDT | UT_TESTF_FLAT_TREE);
+
+/*
+ * Check that a cached property is not returned once it belongs to another
+ * node, after libfdt edits which keep the size of the structure block
+ */
+static int dm_test_ofnode_prop_cache_owner(struct unit_test_state *uts)
+{
+	void *fdt = (void *)gd->fdt_blob;
+	const struct fdt_property *prop;
+	int a, b, size, xoff;
+	ofnode node;
+	u32 val;
+
+	/* pc-a holds y then x; pc-b follows it and has no properties */
+	ut_assert(fdt_add_subnode(fdt, 0, "pc-b") >= 0);
+	a = fdt_add_subnode(fdt, 0, "pc-a");
+	ut_assert(a >= 0);
+	ut_assertok(fdt_setprop_u32(fdt, a, "x", 2));
+	ut_assertok(fdt_setprop_u32(fdt, a, "y", 1));
+
+	node = ofnode_path("/pc-a");
+	ut_assertok(ofnode_read_u32(node, "x", &val));
+	ut_asserteq(2, val);
+	prop = fdt_get_property(fdt, a, "x", NULL);
+	ut_assertnonnull(prop);
+	xoff = (const char *)prop - (const char *)fdt - fdt_off_dt_struct(fdt);
+
+	/* Move both properties to pc-b, so that its x lands where a's was */
+	size = fdt_size_dt_struct(fdt);
+	ut_assertok(fdt_delprop(fdt, a, "y"));
+	ut_assertok(fdt_delprop(fdt, a, "x"));
+	b = fdt_path_offset(fdt, "/pc-b");
+	ut_assert(b >= 0);
+	ut_assertok(fdt_setprop_u32(fdt, b, "y", 4));
+	ut_assertok(fdt_setprop_u32(fdt, b, "x", 5));
+	ut_asserteq(size, fdt_size_dt_struct(fdt));
+	ut_asserteq(xoff, fdt_first_property_offset(fdt, b));
+
+	ut_asserteq(-EINVAL, ofnode_read_u32(node, "x", &val));
+	ut_assertok(ofnode_read_u32(ofnode_path("/pc-b"), "x", &val));
+	ut_asserteq(5, val);
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_prop_cache_owner,
+	UT_TESTF_SCAN_FDT | UT_TESTF_FLAT_TREE);
+
 static int check_prop_values(struct unit_test_state *uts, ofnode start,
 			     const char *propname, const char *propval,
 			     int expect_count)
@@ -133,7 +133,8 @@ static int dm_test_virtio_ring(struct unit_test_state *uts)
 	struct virtqueue *vq;
 	struct virtio_sg sg[2];
 	struct virtio_sg *sgs[2];
-	unsigned int len;
+	struct vring_desc *indir;
+	unsigned int len, i;
 	u8 buffer[2][32];
 
 	/* check probe success */
@@ -193,6 +194,88 @@ static int dm_test_virtio_ring(struct unit_test_state *uts)
 	ut_asserteq(6, len);
 	ut_assertok(virtio_del_vqs(dev));
 
+	/* a multi-buffer chain takes a single indirect descriptor */
+	ut_assertok(virtio_find_vqs(dev, 1, &vq));
+	vq->indirect = true;
+	for (i = 0; i < vq->vring.num; i++)
+		ut_assertok(virtqueue_add(vq, sgs, 1, 1));
+	ut_asserteq(0, vq->num_free);
+	ut_asserteq(VRING_DESC_F_INDIRECT,
+		    virtio16_to_cpu(dev, vq->vring.desc[0].flags));
+	ut_asserteq(2 * sizeof(*indir),
+		    virtio32_to_cpu(dev, vq->vring.desc[0].len));
+	indir = (void *)(uintptr_t)virtio64_to_cpu(dev, vq->vring.desc[0].addr);
+	ut_asserteq_ptr(buffer[0],
+			(void *)(uintptr_t)virtio64_to_cpu(dev, indir[0].addr));
+	ut_asserteq(VRING_DESC_F_NEXT, virtio16_to_cpu(dev, indir[0].flags));
+	ut_asserteq(VRING_DESC_F_WRITE, virtio16_to_cpu(dev, indir[1].flags));
+	vq->vring.used->idx = 1;
+	vq->vring.used->ring[0].id = 0;
+	vq->vring.used->ring[0].len = sizeof(buffer[1]);
+	ut_asserteq_ptr(buffer, virtqueue_get_buf(vq, &len));
+	ut_asserteq(sizeof(buffer[1]), len);
+	ut_asserteq(1, vq->num_free);
+	ut_assertok(virtio_del_vqs(dev));
+
 	return 0;
 }
 DM_TEST(dm_test_virtio_ring, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test the virtio ring with bounce buffers, as used behind an IOMMU */
+static int dm_test_virtio_ring_bounce(struct unit_test_state *uts)
+{
+	struct udevice *bus, *dev;
+	struct virtio_dev_priv *uc_priv;
+	struct virtqueue *vq;
+	struct virtio_sg sg[2];
+	struct virtio_sg *sgs[2];
+	unsigned int len;
+	u8 buffer[2][32];
+	void *bounce;
+
+	if (!IS_ENABLED(CONFIG_BOUNCE_BUFFER))
+		return -EAGAIN;
+
+	ut_assertok(uclass_first_device_err(UCLASS_VIRTIO, &bus));
+	ut_assertok(device_find_first_child(bus, &dev));
+	ut_assertnonnull(dev);
+
+	/* fake the probe, asking for bounce buffers */
+	uc_priv = dev_get_uclass_priv(bus);
+	uc_priv->vdev = dev;
+	uc_priv->features |= BIT_ULL(VIRTIO_F_IOMMU_PLATFORM);
+
+	memset(buffer, '\0', sizeof(buffer));
+	sg[0].addr = buffer[0];
+	sg[0].length = sizeof(buffer[0]);
+	sg[1].addr = buffer[1];
+	sg[1].length = sizeof(buffer[1]);
+	sgs[0] = &sg[0];
+	sgs[1] = &sg[1];
+
+	/* the device sees bounce buffers, never the caller's buffers */
+	ut_assertok(virtio_find_vqs(dev, 1, &vq));
+	ut_assert(!vq->indirect);
+	ut_assertok(virtqueue_add(vq, sgs, 1, 1));
+	ut_asserteq(2, vq->vring.num - vq->num_free);
+	ut_assert(virtio64_to_cpu(dev, vq->vring.desc[0].addr) !=
+		  (uintptr_t)buffer[0]);
+	bounce = (void *)(uintptr_t)virtio64_to_cpu(dev, vq->vring.desc[1].addr);
+	ut_assert(bounce != buffer[1]);
+	memset(bounce, 0xa5, sizeof(buffer[1]));
+
+	/* the caller gets its own first buffer back, with the data written */
+	vq->vring.used->idx = 1;
+	vq->vring.used->ring[0].id = 0;
+	vq->vring.used->ring[0].len = sizeof(buffer[1]);
+	ut_asserteq_ptr(buffer[0], virtqueue_get_buf(vq, &len));
+	ut_asserteq(sizeof(buffer[1]), len);
+	ut_asserteq(0xa5, buffer[1][0]);
+	ut_asserteq(0xa5, buffer[1][sizeof(buffer[1]) - 1]);
+	ut_asserteq(0, buffer[0][0]);
+	ut_assertok(virtio_del_vqs(dev));
+	uc_priv->features &= ~BIT_ULL(VIRTIO_F_IOMMU_PLATFORM);
+
+	return 0;
+}
+DM_TEST(dm_test_virtio_ring_bounce, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
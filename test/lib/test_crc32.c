@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit test for crc32 and crc32c
+ */
+
+#include <common.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+
+static const u8 check_str[] = "123456789";
+
+/* Bit-at-a-time CRC, to check against the table and the CRC instructions */
+static u32 crc_bitwise(u32 crc, const u8 *buf, uint len, u32 poly)
+{
+	int i;
+
+	while (len--) {
+		crc ^= *buf++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (crc & 1 ? poly : 0);
+	}
+
+	return crc;
+}
+
+/* Fill a buffer with bytes which are not all the same */
+static void crc_fill(u8 *buf, uint len)
+{
+	uint i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (i * 0x9e3779b1) >> 24;
+}
+
+/* Check the result at each alignment, and when split into two parts */
+static int lib_crc32(struct unit_test_state *uts)
+{
+	u8 buf[sizeof(check_str) + 8];
+	uint ofs, split;
+	u32 crc;
+
+	ut_asserteq(0xcbf43926, crc32(0, check_str, 9));
+	for (ofs = 0; ofs < 8; ofs++) {
+		memcpy(buf + ofs, check_str, 9);
+		ut_asserteq(0xcbf43926, crc32(0, buf + ofs, 9));
+		for (split = 0; split <= 9; split++) {
+			crc = crc32(0, buf + ofs, split);
+			crc = crc32(crc, buf + ofs + split, 9 - split);
+			ut_asserteq(0xcbf43926, crc);
+		}
+	}
+
+	return 0;
+}
+LIB_TEST(lib_crc32, 0);
+
+/*
+ * Compare with a bitwise CRC over lengths and alignments which use each
+ * part of the word-at-a-time loops, whether the CRC instructions are used
+ * or not
+ */
+static int lib_crc32_words(struct unit_test_state *uts)
+{
+	u8 buf[200 + 8];
+	uint ofs, len;
+
+	crc_fill(buf, sizeof(buf));
+	for (ofs = 0; ofs < 8; ofs++) {
+		for (len = 0; len <= 200; len += 7) {
+			ut_asserteq(~crc_bitwise(~0, buf + ofs, len,
+						 0xedb88320),
+				    crc32(0, buf + ofs, len));
+		}
+	}
+
+	return 0;
+}
+LIB_TEST(lib_crc32_words, 0);
+
+#if CONFIG_IS_ENABLED(CRC32C)
+static int lib_crc32c(struct unit_test_state *uts)
+{
+	u8 buf[200 + 8];
+	u32 table[256];
+	uint ofs, len;
+	u32 crc;
+
+	/* the hardware can be used for this one */
+	crc32c_init(table, 0x82f63b78);
+	for (ofs = 0; ofs < 8; ofs++) {
+		memcpy(buf + ofs, check_str, 9);
+		crc = crc32c_cal(~0, (char *)buf + ofs, 9, table);
+		ut_asserteq(0xe3069283, ~crc);
+	}
+
+	crc_fill(buf, sizeof(buf));
+	for (ofs = 0; ofs < 8; ofs++) {
+		for (len = 0; len <= 200; len += 7) {
+			ut_asserteq(crc_bitwise(~0, buf + ofs, len, 0x82f63b78),
+				    crc32c_cal(~0, (char *)buf + ofs, len,
+					       table));
+		}
+	}
+
+	/* but not for this one, which is the CRC32 polynomial */
+	crc32c_init(table, 0xedb88320);
+	crc = crc32c_cal(~0, (char *)check_str, 9, table);
+	ut_asserteq(0xcbf43926, ~crc);
+
+	return 0;
+}
+LIB_TEST(lib_crc32c, 0);
+#endif
@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for SHA-384 and SHA-512
+ */
+
+#include <common.h>
+#include <hexdump.h>
+#include <malloc.h>
+#include <time.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <linux/sizes.h>
+#include <u-boot/sha512.h>
+
+static const char sha_long[] =
+	"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+	"hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu";
+
+static const struct {
+	const char *msg;
+	const char *sha384;
+	const char *sha512;
+} sha_vectors[] = {
+	{
+		"abc",
+		"cb00753f45a35e8bb5a03d699ac65007272c32ab0eded163"
+		"1a8b605a43ff5bed8086072ba1e7cc2358baeca134c825a7",
+		"ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+		"2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f",
+	}, {
+		sha_long,
+		"09330c33f71147e83d192fc782cd1b4753111b173b3b05d2"
+		"2fa08086e3b0f712fcc7c71a557e2db966c3e9fa91746039",
+		"8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018"
+		"501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909",
+	},
+};
+
+/* Check the FIPS 180-2 examples, also passing the message in two parts */
+static int lib_sha512(struct unit_test_state *uts)
+{
+	u8 expect[SHA512_SUM_LEN], out[SHA512_SUM_LEN];
+	sha512_context ctx;
+	uint i, len, split;
+
+	for (i = 0; i < ARRAY_SIZE(sha_vectors); i++) {
+		const u8 *msg = (const u8 *)sha_vectors[i].msg;
+
+		len = strlen(sha_vectors[i].msg);
+		ut_assertok(hex2bin(expect, sha_vectors[i].sha512,
+				    SHA512_SUM_LEN));
+		for (split = 0; split <= len; split++) {
+			sha512_starts(&ctx);
+			sha512_update(&ctx, msg, split);
+			sha512_update(&ctx, msg + split, len - split);
+			sha512_finish(&ctx, out);
+			ut_asserteq_mem(expect, out, SHA512_SUM_LEN);
+		}
+
+		if (!IS_ENABLED(CONFIG_SHA384))
+			continue;
+		ut_assertok(hex2bin(expect, sha_vectors[i].sha384,
+				    SHA384_SUM_LEN));
+		sha384_csum_wd(msg, len, out, CHUNKSZ_SHA384);
+		ut_asserteq_mem(expect, out, SHA384_SUM_LEN);
+	}
+
+	return 0;
+}
+LIB_TEST(lib_sha512, 0);
+
+/*
+ * Check that sha512_process(), which may be accelerated, gives the same result
+ * as the C version for various numbers of blocks
+ */
+static int lib_sha512_process(struct unit_test_state *uts)
+{
+	static const uint counts[] = { 1, 2, 3, 7, 16 };
+	u8 buf[16 * SHA512_BLOCK_SIZE];
+	sha512_context ctx, generic;
+	uint i;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i * 151 + (i >> 7);
+
+	for (i = 0; i < ARRAY_SIZE(counts); i++) {
+		sha512_starts(&ctx);
+		generic = ctx;
+		sha512_process(&ctx, buf, counts[i]);
+		sha512_process_generic(&generic, buf, counts[i]);
+		ut_asserteq_mem(generic.state, ctx.state, sizeof(ctx.state));
+	}
+
+	return 0;
+}
+LIB_TEST(lib_sha512_process, 0);
+
+/*
+ * Show the speed of sha512_process(), which may be accelerated, and of the C
+ * version. This only runs when requested with 'ut -f'
+ */
+static int lib_sha512_speed_norun(struct unit_test_state *uts)
+{
+	const uint blocks = SZ_1M / SHA512_BLOCK_SIZE;
+	sha512_context ctx, generic;
+	ulong start, accel_us, generic_us;
+	u8 *buf;
+	uint i;
+
+	buf = malloc(SZ_1M);
+	ut_assertnonnull(buf);
+	for (i = 0; i < SZ_1M; i++)
+		buf[i] = i * 151 + (i >> 11);
+
+	sha512_starts(&ctx);
+	generic = ctx;
+
+	start = timer_get_us();
+	sha512_process(&ctx, buf, blocks);
+	accel_us = timer_get_us() - start;
+
+	start = timer_get_us();
+	sha512_process_generic(&generic, buf, blocks);
+	generic_us = timer_get_us() - start;
+
+	ut_asserteq_mem(generic.state, ctx.state, sizeof(ctx.state));
+	printf("sha512: %lu KiB/s, generic %lu KiB/s\n",
+	       SZ_1K * 1000000UL / max(accel_us, 1UL),
+	       SZ_1K * 1000000UL / max(generic_us, 1UL));
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_sha512_speed_norun, UT_TESTF_MANUAL);